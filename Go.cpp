@@ -316,7 +316,7 @@ struct State {
     }
 
     int bIn() {
-        int x, y;
+        int x = -1, y = -1;  // Unreadable input is off the board, a pass
         char comma;
         std::cout << "Enter Coords (x,y): ";
         if (std::cin >> x >> comma >> y && comma == ',') {
@@ -328,7 +328,7 @@ struct State {
     } 
     
     int wIn() {
-        int x, y;
+        int x = -1, y = -1;  // Unreadable input is off the board, a pass
         char comma;
         std::cout << "Enter Coords (x,y): ";
         if (std::cin >> x >> comma >> y && comma == ',') {
@@ -343,19 +343,28 @@ struct State {
 int main() {
     State s;
     s.setGameActive(1);
+    int passes = 0;
     
     std::cout << "\nsizeof(State) = " << sizeof(State) << " bytes\n";
 
     while (s.getGameActive()) {
         std::cout << "\n";
+        s.prettyPrint();
+        std::cout << (s.getTurnState() ? "\nWhite Turn ---- \n" : "\nBlack Turn ---- \n");
+        int idx = s.getTurnState() ? s.wIn() : s.bIn();
+
+        // Off-board coordinates pass; two passes in a row end the game
+        if (idx < 0 || idx >= 361) {
+            s.setTurnState(!s.getTurnState());
+            if (++passes == 2) s.setGameActive(false);
+            continue;
+        }
+        passes = 0;
+
         if (s.getTurnState()) {
-            s.prettyPrint();
-            std::cout << "\nWhite Turn ---- \n";
-            s.setWhite(s.wIn(), true);
+            s.setWhite(idx, true);
         } else {
-            s.prettyPrint();
-            std::cout << "\nBlack Turn ---- \n";
-            s.setBlack(s.bIn(), true);
+            s.setBlack(idx, true);
         }
     } 
     return 0;
@@ -12,6 +12,36 @@
 #include <vector>
 #include <queue>
 #include <random>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <type_traits>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
 
 // Comment out this line to run the game instead of benchmarks
 #define RUN_BENCHMARKS
@@ -314,7 +344,7 @@ struct State {
     }
 
     int bIn() {
-        int x, y;
+        int x = -1, y = -1;  // Unreadable input is off the board, a pass
         char comma;
         std::cout << "xy: ";
         if (std::cin >> x >> comma >> y && comma == ',') {
@@ -326,7 +356,7 @@ struct State {
     } 
     
     int wIn() {
-        int x, y;
+        int x = -1, y = -1;  // Unreadable input is off the board, a pass
         char comma;
         std::cout << "xy: ";
         if (std::cin >> x >> comma >> y && comma == ',') {
@@ -340,279 +370,3902 @@ struct State {
 
 const std::array<std::vector<int>, 361> State::all_neighbors = State::initNeighbors();
 
-#ifdef RUN_BENCHMARKS
+// MARK: --- Bitboards and Zobrist Hashing ---
+// 361-bit board masks in six 64-bit words, bit i = point i. Neighbour shifts
+// mask the first and last columns so nothing wraps between rows.
 
-// MARK: --- Google Benchmark Code ---
+struct Bitboard {
+    std::array<uint64_t, 6> w{};
 
-// Benchmark basic stone operations
-static void BM_StonePlacement(benchmark::State& state) {
-    State go_state;
-    int position = 180; // Center of board
-    
-    for (auto _ : state) {
-        go_state.setBlack(position, true);
-        go_state.setBlack(position, false); // Reset for next iteration
+    static Bitboard single(int idx) {
+        Bitboard b;
+        b.set(idx);
+        return b;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_StonePlacement);
 
-static void BM_StoneRetrieval(benchmark::State& state) {
-    State go_state;
-    go_state.setBlack(180, true);
-    
-    for (auto _ : state) {
-        bool stone = go_state.getBlack(180);
-        benchmark::DoNotOptimize(stone);
+    static Bitboard initColumnMask(int column) {
+        Bitboard b;
+        for (int y = 0; y < 19; ++y) b.set(column + 19 * y);
+        return b;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_StoneRetrieval);
 
-// Benchmark different board positions
-static void BM_StonesByPosition(benchmark::State& state) {
-    State go_state;
-    int position = state.range(0);
-    
-    for (auto _ : state) {
-        if (go_state.isEmpty(position)) {
-            go_state.setBlack(position, true);
-            go_state.setBlack(position, false);
+    static Bitboard initBoardMask() {
+        Bitboard b;
+        for (int idx = 0; idx < 361; ++idx) b.set(idx);
+        return b;
+    }
+
+    static const Bitboard board;
+    static const Bitboard notColumn0;
+    static const Bitboard notColumn18;
+
+    // State keeps black at bits 0-360 and white at 361-721 of its byte array;
+    // both are copied out with one unaligned shift (little-endian layout)
+    static Bitboard fromState(const State& s, bool isBlack) {
+        uint64_t raw[12] = {};
+        std::memcpy(raw, s.data.data(), sizeof(s.data));
+        int word = isBlack ? 0 : 361 / 64;
+        int bit  = isBlack ? 0 : 361 % 64;
+        Bitboard b;
+        for (int i = 0; i < 6; ++i) {
+            b.w[i] = bit ? (raw[word + i] >> bit) | (raw[word + i + 1] << (64 - bit)) : raw[word + i];
         }
+        return b & board;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_StonesByPosition)->Arg(0)->Arg(18)->Arg(180)->Arg(342)->Arg(360); // Corners, center, edges
 
-// Benchmark liberty counting
-static void BM_LibertyCount(benchmark::State& state) {
-    State go_state;
-    
-    // Set up a test pattern with varying liberty counts
-    go_state.setBlack(180, true); // Center - should have 4 liberties initially
-    go_state.setBlack(181, true); // Adjacent
-    go_state.setBlack(199, true); // Adjacent
-    
-    for (auto _ : state) {
-        int liberties = go_state.countLiberties(180, true);
-        benchmark::DoNotOptimize(liberties);
+    // Inverse of fromState: ORs the set points into the black or white plane
+    void addToState(State& s, bool isBlack) const {
+        uint64_t raw[12] = {};
+        std::memcpy(raw, s.data.data(), sizeof(s.data));
+        int word = isBlack ? 0 : 361 / 64;
+        int bit  = isBlack ? 0 : 361 % 64;
+        for (int i = 0; i < 6; ++i) {
+            raw[word + i] |= w[i] << bit;
+            if (bit) raw[word + i + 1] |= w[i] >> (64 - bit);
+        }
+        std::memcpy(s.data.data(), raw, sizeof(s.data));
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_LibertyCount);
 
-// Benchmark fast liberty check
-static void BM_HasLiberties(benchmark::State& state) {
-    State go_state;
-    
-    // Set up a test pattern
-    go_state.setBlack(180, true);
-    go_state.setBlack(181, true);
-    
-    for (auto _ : state) {
-        bool hasLibs = go_state.hasLiberties(180, true);
-        benchmark::DoNotOptimize(hasLibs);
+    bool test(int idx) const { return (w[idx >> 6] >> (idx & 63)) & 1; }
+    void set(int idx)        { w[idx >> 6] |= 1ull << (idx & 63); }
+    void reset(int idx)      { w[idx >> 6] &= ~(1ull << (idx & 63)); }
+
+    bool any() const {
+        uint64_t acc = 0;
+        for (uint64_t x : w) acc |= x;
+        return acc != 0;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_HasLiberties);
 
-// Benchmark capture detection
-static void BM_CaptureDetection(benchmark::State& state) {
-    State go_state;
-    
-    // Set up a capture scenario - white stone surrounded
-    go_state.setWhite(180, true); // Center stone
-    go_state.setBlack(179, true); // Left
-    go_state.setBlack(181, true); // Right
-    go_state.setBlack(161, true); // Up
-    // Leave bottom (199) open for the capturing move
-    
-    for (auto _ : state) {
-        int captured = go_state.checkAndProcessCaptures(199, true);
-        benchmark::DoNotOptimize(captured);
-        
-        // Reset the captured stone for next iteration
-        if (captured > 0) {
-            go_state.setWhite(180, true);
+    int count() const {
+        int n = 0;
+        for (uint64_t x : w) n += __builtin_popcountll(x);
+        return n;
+    }
+
+    // True when more than k points are set. Looks at k + 1 bits at most, so
+    // small k beats count() by far when popcount is not a native instruction.
+    bool moreThan(int k) const {
+        for (uint64_t x : w) {
+            for (; x; x &= x - 1) {
+                if (k-- == 0) return true;
+            }
         }
+        return false;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_CaptureDetection);
 
-// Benchmark suicide move detection
-static void BM_SuicideDetection(benchmark::State& state) {
-    State go_state;
-    
-    // Set up scenario where placing a stone would be suicide
-    go_state.setWhite(179, true); // Left
-    go_state.setWhite(181, true); // Right
-    go_state.setWhite(161, true); // Up
-    go_state.setWhite(199, true); // Down
-    // Center (180) would be suicide for black
-    
-    for (auto _ : state) {
-        bool isSuicide = go_state.isSuicideMove(180, true);
-        benchmark::DoNotOptimize(isSuicide);
+    // Lowest set point, or -1 when empty
+    int first() const {
+        for (int i = 0; i < 6; ++i) {
+            if (w[i]) return 64 * i + __builtin_ctzll(w[i]);
+        }
+        return -1;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_SuicideDetection);
 
-// Benchmark neighbor calculation
-static void BM_GetNeighbors(benchmark::State& state) {
-    State go_state;
-    int position = state.range(0);
-    
-    for (auto _ : state) {
-        const std::vector<int>& neighbors = go_state.getNeighbors(position);
-        benchmark::DoNotOptimize(neighbors);
+    // The k-th set point in index order, k < count(); -1 when there is none
+    int select(int k) const {
+        for (int i = 0; i < 6; ++i) {
+            int c = __builtin_popcountll(w[i]);
+            if (k < c) return 64 * i + selectInWord(w[i], k);
+            k -= c;
+        }
+        return -1;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_GetNeighbors)->Arg(0)->Arg(18)->Arg(180)->Arg(342)->Arg(360); // Different positions
 
-// Benchmark group finding
-static void BM_GetGroup(benchmark::State& state) {
-    State go_state;
-    
-    // Create a group of connected stones
-    std::vector<int> positions = {180, 181, 182, 199, 200, 201};
-    for (int pos : positions) {
-        go_state.setBlack(pos, true);
+    static int selectInWord(uint64_t x, int k) {
+#ifdef __BMI2__
+        return __builtin_ctzll(_pdep_u64(uint64_t(1) << k, x));
+#else
+        int shift = 0;
+        for (int c; k >= (c = __builtin_popcountll(x & 0xFF)); k -= c) {
+            x >>= 8;
+            shift += 8;
+        }
+        for (; k > 0; --k) x &= x - 1;
+        return shift + __builtin_ctzll(x);
+#endif
     }
-    
-    for (auto _ : state) {
-        std::vector<int> group = go_state.getGroup(180, true);
-        benchmark::DoNotOptimize(group);
+
+    template <class F>
+    void forEach(F f) const {
+        for (int i = 0; i < 6; ++i) {
+            for (uint64_t x = w[i]; x; x &= x - 1) f(64 * i + __builtin_ctzll(x));
+        }
     }
-    
-    state.SetItemsProcessed(state.iterations());
-}
-BENCHMARK(BM_GetGroup);
 
-// Benchmark full move sequence
-static void BM_FullMoveSequence(benchmark::State& state) {
-    for (auto _ : state) {
-        State go_state;
-        
-        // Play a sequence of moves
-        go_state.setBlack(180, true);  // Center
-        go_state.setWhite(181, true);  // Adjacent
-        go_state.setBlack(199, true);  // Adjacent to center
-        go_state.setWhite(200, true);  // Adjacent to previous white
-        
-        benchmark::DoNotOptimize(go_state);
+    Bitboard operator&(const Bitboard& o) const { Bitboard r; for (int i = 0; i < 6; ++i) r.w[i] = w[i] & o.w[i]; return r; }
+    Bitboard operator|(const Bitboard& o) const { Bitboard r; for (int i = 0; i < 6; ++i) r.w[i] = w[i] | o.w[i]; return r; }
+    Bitboard operator^(const Bitboard& o) const { Bitboard r; for (int i = 0; i < 6; ++i) r.w[i] = w[i] ^ o.w[i]; return r; }
+    Bitboard andNot(const Bitboard& o) const    { Bitboard r; for (int i = 0; i < 6; ++i) r.w[i] = w[i] & ~o.w[i]; return r; }
+    Bitboard& operator|=(const Bitboard& o) { for (int i = 0; i < 6; ++i) w[i] |= o.w[i]; return *this; }
+    Bitboard& operator&=(const Bitboard& o) { for (int i = 0; i < 6; ++i) w[i] &= o.w[i]; return *this; }
+    bool operator==(const Bitboard& o) const { return w == o.w; }
+    bool operator!=(const Bitboard& o) const { return w != o.w; }
+
+    // Shift towards higher point indices by k < 64
+    Bitboard shiftUp(int k) const {
+        Bitboard r;
+        r.w[0] = w[0] << k;
+        for (int i = 1; i < 6; ++i) r.w[i] = (w[i] << k) | (w[i - 1] >> (64 - k));
+        return r;
     }
-    
-    state.SetItemsProcessed(state.iterations() * 4); // 4 moves per iteration
-}
-BENCHMARK(BM_FullMoveSequence);
 
-// Memory and state management benchmarks
-static void BM_StateCreation(benchmark::State& state) {
-    for (auto _ : state) {
-        State go_state;
-        benchmark::DoNotOptimize(go_state);
+    // Shift towards lower point indices by k < 64
+    Bitboard shiftDown(int k) const {
+        Bitboard r;
+        for (int i = 0; i < 5; ++i) r.w[i] = (w[i] >> k) | (w[i + 1] << (64 - k));
+        r.w[5] = w[5] >> k;
+        return r;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-    state.SetBytesProcessed(state.iterations() * sizeof(State));
-}
-BENCHMARK(BM_StateCreation);
 
-static void BM_StateCopy(benchmark::State& state) {
-    State original;
-    original.setBlack(180, true);
-    original.setWhite(181, true);
-    
-    for (auto _ : state) {
-        State copy = original;
-        benchmark::DoNotOptimize(copy);
+    // Orthogonal neighbours of every set point
+    Bitboard neighbours() const {
+        return ((*this & notColumn18).shiftUp(1)
+              | (*this & notColumn0).shiftDown(1)
+              | shiftUp(19) | shiftDown(19)) & board;
     }
-    
-    state.SetItemsProcessed(state.iterations());
-    state.SetBytesProcessed(state.iterations() * sizeof(State));
-}
-BENCHMARK(BM_StateCopy);
 
-// Benchmark game simulation
-static void BM_GameSimulation(benchmark::State& state) {
-    for (auto _ : state) {
-        State go_state;
-        std::mt19937 gen(42); // Fixed seed for reproducibility
-        std::uniform_int_distribution<> dist(0, 360);
-        
-        int moves = 0;
-        int max_moves = state.range(0);
-        
-        while (moves < max_moves) {
-            int pos = dist(gen);
-            if (go_state.isEmpty(pos)) {
-                if (moves % 2 == 0) {
-                    go_state.setBlack(pos, true);
-                } else {
-                    go_state.setWhite(pos, true);
-                }
-                moves++;
-            }
+    // Points with at least two orthogonal neighbours in this set
+    Bitboard twoNeighbours() const {
+        Bitboard a = (*this & notColumn18).shiftUp(1);
+        Bitboard b = (*this & notColumn0).shiftDown(1);
+        Bitboard c = shiftUp(19);
+        Bitboard d = shiftDown(19);
+        return ((a & b) | (c & d) | ((a | b) & (c | d))) & board;
+    }
+
+    Bitboard dilate() const { return *this | neighbours(); }
+
+    // Grow this set through connected points of `within`
+    Bitboard fill(const Bitboard& within) const {
+        Bitboard current = *this & within;
+        for (;;) {
+            Bitboard grown = current.dilate() & within;
+            if (grown == current) return current;
+            current = grown;
         }
-        
-        benchmark::DoNotOptimize(go_state);
     }
-    
-    state.SetItemsProcessed(state.iterations() * state.range(0));
-}
-BENCHMARK(BM_GameSimulation)->Arg(10)->Arg(50)->Arg(100);
+};
 
-// Custom counter example
-static void BM_WithCustomCounters(benchmark::State& state) {
-    State go_state;
-    size_t stones_placed = 0;
-    size_t captures = 0;
-    
-    for (auto _ : state) {
-        int pos = stones_placed % 361;
-        if (go_state.isEmpty(pos)) {
-            go_state.setBlack(pos, true);
-            stones_placed++;
+const Bitboard Bitboard::board = Bitboard::initBoardMask();
+const Bitboard Bitboard::notColumn0 = Bitboard::board.andNot(Bitboard::initColumnMask(0));
+const Bitboard Bitboard::notColumn18 = Bitboard::board.andNot(Bitboard::initColumnMask(18));
+
+namespace Zobrist {
+    inline uint64_t splitmix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    struct Keys {
+        std::array<std::array<uint64_t, 361>, 2> stone;  // 0 black, 1 white
+        std::array<uint64_t, 361> anchor;               // Salts a hash with a point of interest
+        uint64_t whiteToMove;
+        std::array<uint64_t, 361> ko;                   // Point the side to move may not retake
+    };
+
+    inline Keys initKeys() {
+        Keys k;
+        uint64_t seed = 0x476F2B2B456E67ull;  // Fixed so hashes are stable across runs and builds
+        for (auto& color : k.stone) {
+            for (auto& key : color) key = splitmix64(seed);
         }
+        for (auto& key : k.anchor) key = splitmix64(seed);
+        k.whiteToMove = splitmix64(seed);
+        for (auto& key : k.ko) key = splitmix64(seed);
+        return k;
+    }
+
+    static const Keys keys = initKeys();
+
+    inline uint64_t hash(const Bitboard& black, const Bitboard& white) {
+        uint64_t h = 0;
+        black.forEach([&](int idx) { h ^= keys.stone[0][idx]; });
+        white.forEach([&](int idx) { h ^= keys.stone[1][idx]; });
+        return h;
+    }
+
+    inline uint64_t hash(const State& s) {
+        uint64_t h = hash(Bitboard::fromState(s, true), Bitboard::fromState(s, false));
+        return s.getTurnState() ? h ^ keys.whiteToMove : h;
     }
-    
-    state.counters["StonesPlaced"] = stones_placed;
-    state.counters["StonesPerSecond"] = benchmark::Counter(
-        stones_placed, benchmark::Counter::kIsRate);
-    state.counters["MemoryUsage"] = sizeof(State);
 }
-BENCHMARK(BM_WithCustomCounters);
 
-// Main function for benchmarks
-BENCHMARK_MAIN();
+// MARK: --- Random Numbers for Playouts ---
+// xoshiro256++: 32 bytes of state and a few adds, shifts and rotates per
+// 64-bit output, so each thread or job can own one. It meets the standard
+// UniformRandomBitGenerator interface and drops into every Rng template.
+//
+// Generators are seeded from (seed, stream) through splitmix64 rather than
+// from a shared generator, so the numbers a job sees depend only on its own
+// index: parallel runs are bit-identical whatever the thread count or order.
 
-#else
+struct Xoshiro256pp {
+    using result_type = uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~uint64_t(0); }
 
-// MARK: --- Game Main Function ---
-int main() {
-    State s;
-    s.setGameActive(1);
+    std::array<uint64_t, 4> s;
+
+    explicit Xoshiro256pp(uint64_t seed = 0, uint64_t stream = 0) {
+        uint64_t x = seed ^ Zobrist::splitmix64(stream);
+        for (auto& word : s) word = Zobrist::splitmix64(x);
+    }
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    result_type operator()() {
+        uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Unbiased integer in [0, n) by bitmask rejection: no division, and one
+    // 64-bit output serves several tries for board-sized n
+    uint32_t below(uint32_t n) {
+        if (n <= 1) return 0;
+        int bits = 32 - __builtin_clz(n - 1);
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        for (;;) {
+            uint64_t x = (*this)();
+            for (int used = 0; used + bits <= 64; used += bits) {
+                uint32_t r = (x >> used) & mask;
+                if (r < n) return r;
+            }
+        }
+    }
+};
+
+// Integer in [0, n), n > 0, with whatever the generator does best
+template <class Rng>
+uint32_t randomBelow(Rng& rng, uint32_t n) {
+    return std::uniform_int_distribution<uint32_t>(0, n - 1)(rng);
+}
+
+inline uint32_t randomBelow(Xoshiro256pp& rng, uint32_t n) { return rng.below(n); }
+
+// Uniform point of a mask, or -1 when the mask is empty: one draw and a
+// select, whatever the number of points
+template <class Rng>
+int pickUniform(const Bitboard& mask, Rng& rng) {
+    int n = mask.count();
+    return n ? mask.select(randomBelow(rng, n)) : -1;
+}
+
+// MARK: --- Playout Board with Incremental 3x3 Patterns ---
+// Mailbox board used for playouts. Each chain is a circular list of stones with
+// pseudo-liberty counters; a chain is in atari when all of its pseudo-liberties
+// are the same point, i.e. libSum^2 == libs * libSumSq.
+//
+// Every point carries the 3x3 pattern code around it, kept current as stones
+// are placed and captured:
+//   bits 0-15  : 8 neighbours x 2 bits (0 empty, 1 black, 2 white, 3 off-board)
+//   bits 16-19 : neighbour chain is in atari, for the N, E, S, W neighbours
+// Neighbour order is N, E, S, W, NE, SE, SW, NW so the opposite of d is d ^ 2.
+
+namespace Pattern {
+    enum : uint8_t { Empty = 0, Black = 1, White = 2, Edge = 3 };
+
+    constexpr int kBits = 20;
+    constexpr uint32_t kSize = 1u << kBits;
+    constexpr uint32_t kColorMask = 0xFFFF;
+
+    inline int colorAt(uint32_t code, int d) { return (code >> (2 * d)) & 3; }
+    inline bool atariAt(uint32_t code, int d) { return (code >> (16 + d)) & 1; }
+
+    // Swap black and white so a table written for black also serves white
+    inline uint32_t swapColors(uint32_t code) {
+        uint32_t diff = (code ^ (code >> 1)) & 0x5555;  // fields holding 01 or 10
+        return code ^ (diff | (diff << 1));
+    }
+}
+
+// Move weights indexed by pattern code, written from black's point of view
+struct PatternTable {
+    std::vector<uint16_t> weights = std::vector<uint16_t>(Pattern::kSize, 0);
+
+    uint16_t weight(uint32_t code, bool isBlack) const {
+        return weights[isBlack ? code : Pattern::swapColors(code)];
+    }
+
+    void set(uint32_t code, uint16_t w) { weights[code] = w; }
+
+    // Hand-tuned starting point: capture > escape atari > contact > quiet > first line
+    static PatternTable defaults() {
+        PatternTable table;
+        for (uint32_t code = 0; code < Pattern::kSize; ++code) {
+            bool ownEye = true, capture = false, escape = false, contact = false, edge = false;
+            for (int d = 0; d < 4; ++d) {
+                int c = Pattern::colorAt(code, d);
+                bool atari = Pattern::atariAt(code, d);
+                if (c == Pattern::Empty || c == Pattern::White || atari) ownEye = false;
+                if (c == Pattern::White && atari) capture = true;
+                if (c == Pattern::Black && atari) escape = true;
+                if (c == Pattern::Edge) edge = true;
+            }
+            for (int d = 0; d < 8; ++d) {
+                int c = Pattern::colorAt(code, d);
+                if (c == Pattern::Black || c == Pattern::White) contact = true;
+            }
+
+            uint16_t w = 10;
+            if (ownEye)       w = 0;
+            else if (capture) w = 400;
+            else if (escape)  w = 150;
+            else if (contact) w = 30;
+            else if (edge)    w = 3;
+            table.set(code, w);
+        }
+        return table;
+    }
+};
+
+// All-moves-as-first record of one simulation: the colour that played each
+// point first, as one bitmask per colour
+struct AmafRecord {
+    Bitboard black;
+    Bitboard white;
+
+    void record(int p, bool isBlack) {
+        if (p < 0 || black.test(p) || white.test(p)) return;
+        (isBlack ? black : white).set(p);
+    }
+};
+
+// MARK: --- Rule Sets ---
+// The board is a template over a rule-set policy so that the checks a rule set
+// does not need compile away. Presets:
+//   Tromp-Taylor : suicide allowed,   positional superko,  area scoring
+//   Chinese      : suicide forbidden, positional superko,  area scoring
+//   Japanese     : suicide forbidden, simple ko,           territory scoring
+//   New Zealand  : suicide allowed,   situational superko, area scoring
+//   Playout      : suicide forbidden, simple ko,           area scoring
+// Playout rules are what the search and dead-stone code run on: superko
+// positions are rare enough that the per-move hash lookup is not worth paying
+// in random games.
+// Rule sets only parameterise the playout board. State keeps its own fixed
+// rules whatever preset is chosen: suicide is rejected and there is no ko
+// check. toState() only copies the stones across.
+
+enum class KoRule : uint8_t { Simple, PositionalSuperko, SituationalSuperko };
+enum class Scoring : uint8_t { Area, Territory };
+
+template <bool AllowSuicide, KoRule Ko, Scoring Score>
+struct RuleSet {
+    static constexpr bool allowSuicide = AllowSuicide;
+    static constexpr KoRule ko = Ko;
+    static constexpr Scoring scoring = Score;
+    static constexpr bool superko = Ko != KoRule::Simple;
+};
+
+using TrompTaylorRules = RuleSet<true, KoRule::PositionalSuperko, Scoring::Area>;
+using ChineseRules     = RuleSet<false, KoRule::PositionalSuperko, Scoring::Area>;
+using JapaneseRules    = RuleSet<false, KoRule::Simple, Scoring::Territory>;
+using NewZealandRules  = RuleSet<true, KoRule::SituationalSuperko, Scoring::Area>;
+using PlayoutRules     = RuleSet<false, KoRule::Simple, Scoring::Area>;
+
+// Positions seen so far in a game, by Zobrist hash. A 4096-bit filter answers
+// most lookups without scanning the list.
+struct PositionHistory {
+    uint64_t hash = 0;                      // Current stones
+    std::array<uint64_t, 361> chainHash{};  // Hash of each chain's stones, per chain head
+    std::vector<uint64_t> seen;
+    std::array<uint64_t, 64> filter{};
+
+    void clear() {
+        hash = 0;
+        seen.clear();
+        filter = {};
+    }
+
+    bool contains(uint64_t h) const {
+        uint64_t bit = h >> 52;
+        if (!((filter[bit >> 6] >> (bit & 63)) & 1)) return false;
+        return std::find(seen.begin(), seen.end(), h) != seen.end();
+    }
+
+    void add(uint64_t h) {
+        uint64_t bit = h >> 52;
+        filter[bit >> 6] |= uint64_t(1) << (bit & 63);
+        seen.push_back(h);
+    }
+};
+
+struct NoPositionHistory {
+    void clear() {}
+};
+
+// Neighbour tables shared by every rule set
+struct BoardGeometry {
+    static std::array<std::array<int16_t, 8>, 361> initNeighbors8() {
+        static const int dx[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+        static const int dy[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+        std::array<std::array<int16_t, 8>, 361> nbr;
+        for (int idx = 0; idx < 361; ++idx) {
+            int x = idx % 19;
+            int y = idx / 19;
+            for (int d = 0; d < 8; ++d) {
+                int nx = x + dx[d], ny = y + dy[d];
+                nbr[idx][d] = (nx < 0 || nx > 18 || ny < 0 || ny > 18) ? -1 : nx + 19 * ny;
+            }
+        }
+        return nbr;
+    }
+
+    static std::array<uint32_t, 361> initEmptyPatterns() {
+        std::array<uint32_t, 361> codes{};
+        for (int idx = 0; idx < 361; ++idx) {
+            for (int d = 0; d < 8; ++d) {
+                if (nbr8[idx][d] < 0) codes[idx] |= uint32_t(Pattern::Edge) << (2 * d);
+            }
+        }
+        return codes;
+    }
+
+    static const std::array<std::array<int16_t, 8>, 361> nbr8;
+    static const std::array<uint32_t, 361> emptyPatterns;
+};
+
+const std::array<std::array<int16_t, 8>, 361> BoardGeometry::nbr8 = BoardGeometry::initNeighbors8();
+const std::array<uint32_t, 361> BoardGeometry::emptyPatterns = BoardGeometry::initEmptyPatterns();
+
+template <class Rules>
+struct BasicPlayoutBoard : BoardGeometry {
+    static constexpr int kPass = -1;
+
+    std::array<uint8_t, 361> color{};
+    std::array<uint16_t, 361> head{};       // Chain representative of each stone
+    std::array<uint16_t, 361> next{};       // Circular list of the stones in a chain
+    std::array<uint16_t, 361> chainSize{};  // Per chain head
+    std::array<uint16_t, 361> libs{};       // Pseudo-liberties, per chain head
+    std::array<uint32_t, 361> libSum{};
+    std::array<uint32_t, 361> libSumSq{};
+    std::array<uint32_t, 361> pattern{};
+
+    std::array<uint16_t, 361> emptyList{};
+    std::array<uint16_t, 361> emptyIndex{};
+    int numEmpty = 0;
+
+    // Weighted sampling state, only maintained while a pattern table is attached.
+    // Index 0 is black to move, 1 is white to move.
+    const PatternTable* table = nullptr;
+    std::array<std::array<uint32_t, 361>, 2> weight{};
+    std::array<std::array<uint32_t, 19>, 2> rowWeight{};
+    std::array<uint32_t, 2> totalWeight{};
+
+    // Points whose atari bits must be recomputed at the end of a move
+    std::array<uint16_t, 361> dirty{};
+    std::array<uint32_t, 361> dirtyStamp{};
+    int numDirty = 0;
+    uint32_t stamp = 0;
+
+    int koPoint = kPass;  // Only used under simple ko
+    int passes = 0;
+    int moveCount = 0;
+    bool blackToMove = true;
+    std::array<int, 2> prisoners{};  // Stones captured by black, by white
+
+    // Superko rule sets carry the hashes of earlier positions
+    std::conditional_t<Rules::superko, PositionHistory, NoPositionHistory> positions;
+
+    BasicPlayoutBoard() { clear(); }
+    explicit BasicPlayoutBoard(const PatternTable* t) : table(t) { clear(); }
+
+    void clear() {
+        color.fill(Pattern::Empty);
+        pattern = emptyPatterns;
+        for (int i = 0; i < 361; ++i) {
+            emptyList[i] = i;
+            emptyIndex[i] = i;
+        }
+        numEmpty = 361;
+        koPoint = kPass;
+        passes = 0;
+        moveCount = 0;
+        blackToMove = true;
+        prisoners = {};
+        positions.clear();
+        recordPosition();
+        recomputeWeights();
+    }
+
+    void setPatternTable(const PatternTable* t) {
+        table = t;
+        recomputeWeights();
+    }
+
+    // The State carries no history, so superko only sees positions from here on
+    static BasicPlayoutBoard fromState(const State& s, const PatternTable* t = nullptr) {
+        BasicPlayoutBoard board(t);
+        for (int idx = 0; idx < 361; ++idx) {
+            if (s.getBlack(idx))      board.placeStone(idx, Pattern::Black);
+            else if (s.getWhite(idx)) board.placeStone(idx, Pattern::White);
+        }
+        for (int idx = 0; idx < 361; ++idx) board.refreshAtari(idx);
+        board.blackToMove = !s.getTurnState();
+        if constexpr (Rules::superko) {
+            uint64_t h = board.positions.hash;
+            board.positions.clear();
+            board.positions.hash = h;
+        }
+        board.recordPosition();
+        return board;
+    }
+
+    State toState() const {
+        State s;
+        for (int idx = 0; idx < 361; ++idx) {
+            int bitIndex = -1;
+            if (color[idx] == Pattern::Black)      bitIndex = idx;
+            else if (color[idx] == Pattern::White) bitIndex = 361 + idx;
+            if (bitIndex >= 0) s.data[bitIndex / 8] |= (1 << (bitIndex % 8));
+        }
+        s.setTurnState(!blackToMove);
+        s.setGameActive(passes < 2);
+        return s;
+    }
+
+    bool inAtari(int h) const {
+        return libs[h] != 0 && uint64_t(libSum[h]) * libSum[h] == uint64_t(libs[h]) * libSumSq[h];
+    }
+
+    // Only meaningful when inAtari(h)
+    int atariLiberty(int h) const { return libSum[h] / libs[h]; }
+
+    // True when a stone at p keeps a liberty: an empty neighbour, a friendly
+    // chain with a liberty elsewhere, or a capture
+    bool breathes(int p) const {
+        uint8_t own = blackToMove ? Pattern::Black : Pattern::White;
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q < 0) continue;
+            if (color[q] == Pattern::Empty) return true;
+            bool atari = inAtari(head[q]);
+            if (color[q] == own ? !atari : atari) return true;  // Connect out, or capture
+        }
+        return false;
+    }
+
+    bool isLegal(int p) const {
+        if (p == kPass) return true;
+        if (color[p] != Pattern::Empty) return false;
+        if constexpr (Rules::superko) {
+            if (!Rules::allowSuicide && !breathes(p)) return false;
+            return !positions.contains(positionAfter(p));
+        } else {
+            if (p == koPoint) return false;
+            return Rules::allowSuicide || breathes(p);
+        }
+    }
+
+    // Legal, not filling an own eye and not suicide: the moves playouts choose from
+    bool isSensible(int p) const {
+        if (!isLegal(p) || isOwnEye(p)) return false;
+        return !Rules::allowSuicide || breathes(p);
+    }
+
+    // Key of the position a move at p would leave, captures and suicide
+    // included, as stored by recordPosition()
+    uint64_t positionAfter(int p) const {
+        static_assert(Rules::superko, "positionAfter needs position hashes");
+        uint8_t own = blackToMove ? Pattern::Black : Pattern::White;
+        const uint64_t stoneKey = Zobrist::keys.stone[own - 1][p];
+        uint64_t h = positions.hash ^ stoneKey;
+        uint64_t ownChains = stoneKey;
+        int seen[4];
+        int numSeen = 0;
+        bool captures = false, liberty = false;
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q < 0) continue;
+            if (color[q] == Pattern::Empty) {
+                liberty = true;
+                continue;
+            }
+            int hq = head[q];
+            if (std::find(seen, seen + numSeen, hq) != seen + numSeen) continue;
+            seen[numSeen++] = hq;
+            if (color[q] == own) {
+                ownChains ^= positions.chainHash[hq];
+                if (!inAtari(hq)) liberty = true;
+            } else if (inAtari(hq)) {
+                h ^= positions.chainHash[hq];
+                captures = true;
+            }
+        }
+        if (!captures && !liberty) h ^= ownChains;  // Suicide removes the whole chain
+        if (Rules::ko == KoRule::SituationalSuperko && blackToMove) h ^= Zobrist::keys.whiteToMove;
+        return h;
+    }
+
+    void recordPosition() {
+        if constexpr (Rules::superko) {
+            uint64_t h = positions.hash;
+            if (Rules::ko == KoRule::SituationalSuperko && !blackToMove) h ^= Zobrist::keys.whiteToMove;
+            positions.add(h);
+        }
+    }
+
+    // Single-point eye of the side to move that is not a false eye
+    bool isOwnEye(int p) const {
+        uint8_t own = blackToMove ? Pattern::Black : Pattern::White;
+        uint32_t code = pattern[p];
+        for (int d = 0; d < 4; ++d) {
+            int c = Pattern::colorAt(code, d);
+            if ((c != own && c != Pattern::Edge) || Pattern::atariAt(code, d)) return false;
+        }
+        int opponent = 0, offBoard = 0;
+        for (int d = 4; d < 8; ++d) {
+            int c = Pattern::colorAt(code, d);
+            if (c == Pattern::Edge) offBoard++;
+            else if (c == (own ^ 3)) opponent++;
+        }
+        return opponent < (offBoard ? 1 : 2);
+    }
+
+    // Plays a move for the side to move; legality is the caller's responsibility
+    void play(int p) {
+        moveCount++;
+        if (p == kPass) {
+            passes++;
+            koPoint = kPass;
+            blackToMove = !blackToMove;
+            if (Rules::ko == KoRule::SituationalSuperko) recordPosition();
+            return;
+        }
+
+        uint8_t own = blackToMove ? Pattern::Black : Pattern::White;
+        uint8_t opp = own ^ 3;
+        ++stamp;
+        numDirty = 0;
+
+        // Chains touching p may enter or leave atari
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q >= 0 && color[q] != Pattern::Empty) markAtariLiberty(head[q]);
+        }
+
+        placeStone(p, own);
+
+        int captured = 0, capturedPoint = kPass;
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q >= 0 && color[q] == opp && libs[head[q]] == 0) {
+                capturedPoint = q;
+                captured += removeChain(head[q]);
+            }
+        }
+        prisoners[own - 1] += captured;
+        if constexpr (Rules::allowSuicide) {
+            if (libs[head[p]] == 0) prisoners[opp - 1] += removeChain(head[p]);
+        }
+
+        if (color[p] != Pattern::Empty) markAtariLiberty(head[p]);
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q >= 0 && color[q] != Pattern::Empty) markAtariLiberty(head[q]);
+        }
+        for (int i = 0; i < numDirty; ++i) refreshAtari(dirty[i]);
+
+        if constexpr (!Rules::superko) {
+            int h = head[p];
+            bool single = color[p] != Pattern::Empty && chainSize[h] == 1 && inAtari(h);
+            koPoint = (captured == 1 && single) ? capturedPoint : kPass;
+        }
+        passes = 0;
+        blackToMove = !blackToMove;
+        recordPosition();
+    }
+
+    template <class Rng>
+    int sampleUniform(Rng& rng) {
+        int n = numEmpty;
+        while (n > 0) {
+            int i = randomBelow(rng, n);
+            int p = emptyList[i];
+            if (isSensible(p)) return p;
+            swapEmpty(i, --n);  // Park the rejected point outside the candidate range
+        }
+        return kPass;
+    }
+
+    // Samples proportionally to pattern weight; illegal picks are zeroed and
+    // restored once a move is found
+    template <class Rng>
+    int sampleWeighted(Rng& rng) {
+        int s = blackToMove ? 0 : 1;
+        std::array<uint16_t, 361> rejected;
+        int numRejected = 0;
+        int move = kPass;
+
+        while (totalWeight[s] > 0) {
+            uint32_t r = randomBelow(rng, totalWeight[s]);
+            int row = 0;
+            while (r >= rowWeight[s][row]) r -= rowWeight[s][row++];
+            int p = row * 19;
+            while (r >= weight[s][p]) r -= weight[s][p++];
+
+            if (isSensible(p)) {
+                move = p;
+                break;
+            }
+            rejected[numRejected++] = p;
+            rowWeight[s][row] -= weight[s][p];
+            totalWeight[s] -= weight[s][p];
+            weight[s][p] = 0;
+        }
+
+        for (int i = 0; i < numRejected; ++i) updateWeight(rejected[i]);
+        return move;
+    }
+
+    template <class Rng>
+    int sampleMove(Rng& rng) {
+        return table ? sampleWeighted(rng) : sampleUniform(rng);
+    }
+
+    // Plays until both sides pass; returns the number of moves played
+    template <class Rng>
+    int playout(Rng& rng, int maxMoves = 3 * 361, AmafRecord* amaf = nullptr) {
+        int played = 0;
+        while (passes < 2 && played < maxMoves) {
+            int move = sampleMove(rng);
+            if (amaf) amaf->record(move, blackToMove);
+            play(move);
+            played++;
+        }
+        return played;
+    }
+
+    // +1 if p counts for black, -1 for white, 0 for neither. Empty points count
+    // for a colour when all their orthogonal neighbours are that colour, which
+    // settles a finished playout.
+    int owner(int p) const {
+        if (color[p] == Pattern::Black) return 1;
+        if (color[p] == Pattern::White) return -1;
+        bool black = true, white = true;
+        for (int d = 0; d < 4; ++d) {
+            int c = Pattern::colorAt(pattern[p], d);
+            if (c != Pattern::Black && c != Pattern::Edge) black = false;
+            if (c != Pattern::White && c != Pattern::Edge) white = false;
+        }
+        return int(black) - int(white);
+    }
+
+    // Score from black's point of view: stones plus surrounded points under
+    // area scoring, surrounded points plus prisoners under territory scoring
+    float score(float komi = 7.5f) const {
+        int total = 0;
+        if constexpr (Rules::scoring == Scoring::Area) {
+            for (int p = 0; p < 361; ++p) total += owner(p);
+        } else {
+            for (int p = 0; p < 361; ++p) {
+                if (color[p] == Pattern::Empty) total += owner(p);
+            }
+            total += prisoners[0] - prisoners[1];
+        }
+        return total - komi;
+    }
+
+    void addLib(int h, int p)    { libs[h]++; libSum[h] += p; libSumSq[h] += p * p; }
+    void removeLib(int h, int p) { libs[h]--; libSum[h] -= p; libSumSq[h] -= p * p; }
+
+    void addEmpty(int p) {
+        emptyIndex[p] = numEmpty;
+        emptyList[numEmpty++] = p;
+    }
+
+    void removeEmpty(int p) {
+        int i = emptyIndex[p];
+        int last = emptyList[--numEmpty];
+        emptyList[i] = last;
+        emptyIndex[last] = i;
+    }
+
+    void swapEmpty(int i, int j) {
+        std::swap(emptyList[i], emptyList[j]);
+        emptyIndex[emptyList[i]] = i;
+        emptyIndex[emptyList[j]] = j;
+    }
+
+    void markDirty(int p) {
+        if (dirtyStamp[p] != stamp) {
+            dirtyStamp[p] = stamp;
+            dirty[numDirty++] = p;
+        }
+    }
+
+    void markAtariLiberty(int h) {
+        if (inAtari(h)) markDirty(atariLiberty(h));
+    }
+
+    void updateWeight(int p) {
+        if (!table) return;
+        int row = p / 19;
+        for (int s = 0; s < 2; ++s) {
+            uint32_t w = color[p] == Pattern::Empty ? table->weight(pattern[p], s == 0) : 0;
+            rowWeight[s][row] += w - weight[s][p];
+            totalWeight[s] += w - weight[s][p];
+            weight[s][p] = w;
+        }
+    }
+
+    void recomputeWeights() {
+        weight = {};
+        rowWeight = {};
+        totalWeight = {};
+        for (int p = 0; p < 361; ++p) updateWeight(p);
+    }
+
+    void setPattern(int p, uint32_t code) {
+        pattern[p] = code;
+        if (color[p] == Pattern::Empty) updateWeight(p);
+    }
+
+    // Tell the 8 neighbours of p that its colour changed
+    void broadcastColor(int p, uint8_t c) {
+        for (int d = 0; d < 8; ++d) {
+            int q = nbr8[p][d];
+            if (q < 0) continue;
+            int shift = 2 * (d ^ 2);
+            setPattern(q, (pattern[q] & ~(3u << shift)) | (uint32_t(c) << shift));
+        }
+    }
+
+    void refreshAtari(int p) {
+        if (color[p] != Pattern::Empty) return;
+        uint32_t code = pattern[p] & Pattern::kColorMask;
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q >= 0 && color[q] != Pattern::Empty && inAtari(head[q])) code |= 1u << (16 + d);
+        }
+        if (code != pattern[p]) setPattern(p, code);
+    }
+
+    // Adds a stone and merges chains without resolving captures
+    void placeStone(int p, uint8_t c) {
+        removeEmpty(p);
+        color[p] = c;
+        head[p] = p;
+        next[p] = p;
+        chainSize[p] = 1;
+        libs[p] = 0;
+        libSum[p] = 0;
+        libSumSq[p] = 0;
+        if constexpr (Rules::superko) {
+            positions.chainHash[p] = Zobrist::keys.stone[c - 1][p];
+            positions.hash ^= positions.chainHash[p];
+        }
+        updateWeight(p);
+        broadcastColor(p, c);
+
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q < 0) continue;
+            if (color[q] == Pattern::Empty) addLib(p, q);
+            else removeLib(head[q], p);
+        }
+        for (int d = 0; d < 4; ++d) {
+            int q = nbr8[p][d];
+            if (q >= 0 && color[q] == c && head[q] != head[p]) mergeChains(head[p], head[q]);
+        }
+    }
+
+    void mergeChains(int a, int b) {
+        if (chainSize[a] < chainSize[b]) std::swap(a, b);
+        int s = b;
+        do {
+            head[s] = a;
+            s = next[s];
+        } while (s != b);
+        std::swap(next[a], next[b]);
+        chainSize[a] += chainSize[b];
+        libs[a] += libs[b];
+        libSum[a] += libSum[b];
+        libSumSq[a] += libSumSq[b];
+        if constexpr (Rules::superko) positions.chainHash[a] ^= positions.chainHash[b];
+    }
+
+    int removeChain(int h) {
+        if constexpr (Rules::superko) positions.hash ^= positions.chainHash[h];
+        uint8_t c = color[h];
+        int count = 0;
+        int s = h;
+        do {
+            int nextStone = next[s];
+            color[s] = Pattern::Empty;
+            addEmpty(s);
+            broadcastColor(s, Pattern::Empty);
+            markDirty(s);
+            updateWeight(s);
+            for (int d = 0; d < 4; ++d) {
+                int q = nbr8[s][d];
+                if (q >= 0 && color[q] != Pattern::Empty && color[q] != c) {
+                    markAtariLiberty(head[q]);
+                    addLib(head[q], s);
+                }
+            }
+            count++;
+            s = nextStone;
+        } while (s != h);
+        return count;
+    }
+};
+
+using PlayoutBoard = BasicPlayoutBoard<PlayoutRules>;
+
+// MARK: --- Ladder Reader ---
+// Reads ladders on bitboards with make/unmake. The prey chain is carried down
+// the search and only grows, so liberties are one dilation instead of a BFS.
+// The empty plane is kept across make/unmake, and capture and atari tests
+// flood out from the stone that was touched only until they find enough
+// liberties, so a node costs a few local steps however long the ladder is.
+// Verdicts are cached by stone hash and prey chain, so re-reading a ladder
+// during search or playouts is a single lookup.
+
+struct LadderReader {
+    enum Verdict : uint8_t { Unknown = 0, Captured = 1, Escapes = 2 };
+
+    struct Undo {
+        Bitboard captured;
+        uint64_t hash;
+        int16_t move;
+        int16_t ko;
+        uint8_t color;
+    };
+
+    struct Entry {
+        uint64_t key;
+        uint8_t verdict;
+    };
+
+    static constexpr int kMaxDepth = 400;
+
+    std::array<Bitboard, 2> stones;  // 0 black, 1 white
+    Bitboard empties;                // Kept in step with stones by make/unmake
+    uint64_t hash = 0;               // Stones only; node type and ko are salted into cache keys
+    int ko = -1;                     // Simple ko point, so capture cycles end instead of hitting kMaxDepth
+    std::vector<Undo> history;
+    std::vector<Entry> cache;
+    uint64_t cacheMask;
+    size_t nodes = 0;
+
+    explicit LadderReader(int cacheBits = 16)
+        : cache(size_t(1) << cacheBits), cacheMask((uint64_t(1) << cacheBits) - 1) {
+        history.reserve(kMaxDepth + 1);
+    }
+
+    void setPosition(const State& s) {
+        stones[0] = Bitboard::fromState(s, true);
+        stones[1] = Bitboard::fromState(s, false);
+        empties = Bitboard::board.andNot(stones[0] | stones[1]);
+        hash = Zobrist::hash(stones[0], stones[1]);
+        ko = -1;
+        history.clear();
+    }
+
+    void clearCache() { std::fill(cache.begin(), cache.end(), Entry{0, Unknown}); }
+
+    Bitboard chainAt(int p, int c) const { return Bitboard::single(p).fill(stones[c]); }
+
+    Bitboard liberties(const Bitboard& chain) const { return chain.neighbours() & empties; }
+
+    // Number of empty points next to p, a cheap filter before any flood fill
+    int emptyAround(int p) const {
+        int n = 0;
+        for (int d = 0; d < 4; ++d) {
+            int q = PlayoutBoard::nbr8[p][d];
+            n += q >= 0 && empties.test(q);
+        }
+        return n;
+    }
+
+    // Liberties of the chain at p, walked breadth-first from p only until
+    // more than `enough` are found; the stones walked go to `walked` if given.
+    // Point tests keep this local: ladder chains are long but breathe at their
+    // head, a step or two from any stone the search touches, so whole-board
+    // dilations would mostly spin.
+    Bitboard libertiesUpTo(int p, int c, int enough, Bitboard* walked = nullptr) const {
+        Bitboard libs;
+        Bitboard seen = Bitboard::single(p);
+        std::array<int16_t, 361> queue;
+        int head = 0, tail = 0, found = 0;
+        queue[tail++] = int16_t(p);
+        while (head < tail && found <= enough) {
+            int s = queue[head++];
+            for (int d = 0; d < 4; ++d) {
+                int q = PlayoutBoard::nbr8[s][d];
+                if (q < 0) continue;
+                if (empties.test(q)) {
+                    found += !libs.test(q);
+                    libs.set(q);
+                } else if (stones[c].test(q) && !seen.test(q)) {
+                    seen.set(q);
+                    queue[tail++] = int16_t(q);
+                }
+            }
+        }
+        if (walked) *walked = seen;
+        return libs;
+    }
+
+    // Places a stone of colour c (0 black, 1 white) and removes captures.
+    // Returns false and leaves the board untouched for suicide or a ko retake.
+    bool make(int p, int c) {
+        if (p == ko) return false;
+        int opp = c ^ 1;
+        Undo u{{}, hash, int16_t(p), int16_t(ko), uint8_t(c)};
+        stones[c].set(p);
+        empties.reset(p);
+        hash ^= Zobrist::keys.stone[c][p];
+
+        for (int d = 0; d < 4; ++d) {
+            int q = PlayoutBoard::nbr8[p][d];
+            if (q < 0 || !stones[opp].test(q) || u.captured.test(q) || emptyAround(q)) continue;
+            if (!libertiesUpTo(q, opp, 0).any()) u.captured |= chainAt(q, opp);
+        }
+
+        ko = -1;
+        if (u.captured.any()) {
+            stones[opp] = stones[opp].andNot(u.captured);
+            empties |= u.captured;
+            u.captured.forEach([&](int s) { hash ^= Zobrist::keys.stone[opp][s]; });
+            // A lone stone that took one stone and breathes only there
+            if (!u.captured.moreThan(1) && emptyAround(p) == 1 && !(around(p) & stones[c]).any()) {
+                ko = u.captured.first();
+            }
+        } else if (!emptyAround(p) && !libertiesUpTo(p, c, 0).any()) {
+            stones[c].reset(p);
+            empties.set(p);
+            hash = u.hash;
+            ko = u.ko;
+            return false;
+        }
+
+        history.push_back(u);
+        return true;
+    }
+
+    void unmake() {
+        const Undo& u = history.back();
+        stones[u.color].reset(u.move);
+        stones[u.color ^ 1] |= u.captured;
+        empties.set(u.move);
+        empties = empties.andNot(u.captured);
+        hash = u.hash;
+        ko = u.ko;
+        history.pop_back();
+    }
+
+    // Can the chain at p be captured in a ladder? With one liberty the prey moves
+    // first, with two the attacker does; three or more liberties always escape.
+    Verdict read(const State& s, int p) {
+        setPosition(s);
+        return read(p);
+    }
+
+    Verdict read(int p) {
+        int c = stones[0].test(p) ? 0 : stones[1].test(p) ? 1 : -1;
+        if (c < 0) return Unknown;
+        Bitboard chain = chainAt(p, c);
+        Prey prey{chain, chain.neighbours(), {}, {}};
+        int libs = liberties(prey).count();
+        if (libs >= 3) return Escapes;
+        bool captured = libs == 1 ? preyToMove(prey, c, 0) : attackerToMove(prey, c, 0);
+        return captured ? Captured : Escapes;
+    }
+
+    // The prey chain plus its orthogonal border, grown incrementally so each
+    // node gets its liberties with one AND. Attacker stones next to it that
+    // were seen with two liberties stay safe, without another walk, while
+    // those witness liberties stay empty and the prey captures nothing.
+    struct Prey {
+        Bitboard chain;
+        Bitboard border;
+        Bitboard safe;
+        Bitboard witnesses;
+    };
+
+    Bitboard liberties(const Prey& prey) const { return prey.border & empties; }
+
+    static Bitboard around(int p) {
+        Bitboard b;
+        for (int d = 0; d < 4; ++d) {
+            int q = PlayoutBoard::nbr8[p][d];
+            if (q >= 0) b.set(q);
+        }
+        return b;
+    }
+
+    uint64_t cacheKey(const Prey& prey, bool preyTurn) const {
+        uint64_t key = hash ^ Zobrist::keys.anchor[prey.chain.first()];
+        if (ko >= 0) key ^= Zobrist::keys.ko[ko];
+        return preyTurn ? key ^ Zobrist::keys.whiteToMove : key;
+    }
+
+    // Prey after a stone of its colour lands on p
+    Prey grow(const Prey& prey, int p, int c) const {
+        Prey grown = prey;
+        if (history.back().captured.any()) grown.safe = grown.witnesses = Bitboard();
+        if (!prey.border.test(p)) return grown;
+        Bitboard next = around(p);
+        grown.chain.set(p);
+        grown.border |= next;
+        Bitboard others = next & stones[c].andNot(prey.chain);
+        if (others.any()) {
+            others = others.fill(stones[c].andNot(grown.chain));
+            grown.chain |= others;
+            grown.border |= others.neighbours();
+        }
+        return grown;
+    }
+
+    // Prey is in atari and to move; true if it cannot get out
+    bool preyToMove(Prey prey, int c, int depth) {
+        uint64_t key = cacheKey(prey, true);
+        Entry& slot = cache[key & cacheMask];
+        if (slot.key == key && slot.verdict != Unknown) return slot.verdict == Captured;
+        nodes++;
+
+        int a = c ^ 1;
+        bool captured = true;
+
+        // Capture an attacker chain that is itself in atari
+        if ((prey.witnesses & empties) != prey.witnesses) prey.safe = prey.witnesses = Bitboard();
+        Bitboard adjacent = (prey.border & stones[a]).andNot(empties.twoNeighbours() | prey.safe);
+        Bitboard tried;
+        while (captured && adjacent.any()) {
+            int q = adjacent.first();
+            adjacent.reset(q);
+            Bitboard walked;
+            Bitboard libs = libertiesUpTo(q, a, 1, &walked);
+            if (libs.moreThan(1)) {
+                prey.safe |= walked;
+                prey.witnesses |= libs;
+                adjacent = adjacent.andNot(walked);
+                continue;
+            }
+            int lib = libs.first();
+            if (lib < 0 || tried.test(lib)) continue;
+            tried.set(lib);
+            if (!make(lib, c)) continue;
+            captured = depth < kMaxDepth && attackerToMove(grow(prey, lib, c), c, depth + 1);
+            unmake();
+        }
+
+        // Extend at the last liberty
+        if (captured) {
+            int lib = (prey.border & empties).first();
+            if (lib >= 0 && make(lib, c)) {
+                captured = depth < kMaxDepth && attackerToMove(grow(prey, lib, c), c, depth + 1);
+                unmake();
+            }
+        }
+
+        cache[key & cacheMask] = {key, uint8_t(captured ? Captured : Escapes)};
+        return captured;
+    }
+
+    // Attacker to move; true if some atari leads to capture
+    bool attackerToMove(const Prey& prey, int c, int depth) {
+        Bitboard libs = liberties(prey);
+        if (!libs.moreThan(1)) return true;
+        if (libs.moreThan(2)) return false;
+
+        uint64_t key = cacheKey(prey, false);
+        Entry& slot = cache[key & cacheMask];
+        if (slot.key == key && slot.verdict != Unknown) return slot.verdict == Captured;
+        nodes++;
+
+        int a = c ^ 1;
+        int first = libs.first();
+        libs.reset(first);
+        int second = libs.first();
+        // Atari from the side that leaves the prey the cramped escape first
+        if (emptyAround(second) > emptyAround(first)) std::swap(first, second);
+        bool captured = false;
+        for (int lib : { first, second }) {
+            if (!make(lib, a)) continue;
+            // An atari that captures prey-coloured stones can hand the prey liberties
+            Bitboard preyLibs = liberties(prey);
+            captured = depth < kMaxDepth && preyLibs.any() && !preyLibs.moreThan(1) && preyToMove(prey, c, depth + 1);
+            unmake();
+            if (captured) break;
+        }
+
+        cache[key & cacheMask] = {key, uint8_t(captured ? Captured : Escapes)};
+        return captured;
+    }
+};
+
+// MARK: --- Benson's Unconditional Life and Dead Stones ---
+// Benson's algorithm on bitboards. A region is a connected area of points not
+// occupied by the player; it is vital to a chain when every empty point in it
+// is a liberty of that chain. Chains with fewer than two vital regions are
+// removed, then every region touching a removed chain, until nothing changes.
+// What is left can never be captured, even if the opponent moves forever.
+
+struct BensonResult {
+    Bitboard alive;      // Unconditionally alive stones
+    Bitboard territory;  // Vital regions of those stones, opponent stones inside included
+};
+
+inline BensonResult bensonAlive(const Bitboard& own, const Bitboard& opp) {
+    Bitboard empties = Bitboard::board.andNot(own | opp);
+    Bitboard outside = Bitboard::board.andNot(own);
+
+    std::array<int16_t, 361> chainId;
+    std::vector<Bitboard> chains, chainLibs;
+    for (Bitboard rest = own; rest.any();) {
+        Bitboard chain = Bitboard::single(rest.first()).fill(own);
+        rest = rest.andNot(chain);
+        int16_t id = int16_t(chains.size());
+        chain.forEach([&](int p) { chainId[p] = id; });
+        chains.push_back(chain);
+        chainLibs.push_back(chain.neighbours() & empties);
+    }
+
+    // Vital (region, chain) pairs never change, only which of them still count
+    std::vector<Bitboard> regions, regionBorder;
+    std::vector<std::pair<int, int>> vitalPairs;
+    std::vector<int> seen(chains.size(), -1);
+    for (Bitboard rest = outside; rest.any();) {
+        Bitboard region = Bitboard::single(rest.first()).fill(outside);
+        rest = rest.andNot(region);
+        int r = int(regions.size());
+        Bitboard border = region.neighbours() & own;
+        Bitboard regionEmpty = region & empties;
+        border.forEach([&](int p) {
+            int c = chainId[p];
+            if (seen[c] == r) return;
+            seen[c] = r;
+            if (!regionEmpty.andNot(chainLibs[c]).any()) vitalPairs.push_back({ r, c });
+        });
+        regions.push_back(region);
+        regionBorder.push_back(border);
+    }
+
+    std::vector<uint8_t> chainAlive(chains.size(), 1), regionAlive(regions.size(), 1);
+    std::vector<int> vitalRegions(chains.size());
+    for (;;) {
+        std::fill(vitalRegions.begin(), vitalRegions.end(), 0);
+        for (const auto& [r, c] : vitalPairs) {
+            if (regionAlive[r]) vitalRegions[c]++;
+        }
+
+        Bitboard removed;
+        for (size_t c = 0; c < chains.size(); ++c) {
+            if (chainAlive[c] && vitalRegions[c] < 2) {
+                chainAlive[c] = 0;
+                removed |= chains[c];
+            }
+        }
+        if (!removed.any()) break;
+        for (size_t r = 0; r < regions.size(); ++r) {
+            if (regionAlive[r] && (regionBorder[r] & removed).any()) regionAlive[r] = 0;
+        }
+    }
+
+    BensonResult result;
+    for (size_t c = 0; c < chains.size(); ++c) {
+        if (chainAlive[c]) result.alive |= chains[c];
+    }
+    for (const auto& [r, c] : vitalPairs) {
+        if (regionAlive[r] && chainAlive[c]) result.territory |= regions[r];
+    }
+    return result;
+}
+
+inline Bitboard colorMask(const PlayoutBoard& board, uint8_t c) {
+    Bitboard mask;
+    for (int p = 0; p < 361; ++p) {
+        if (board.color[p] == c) mask.set(p);
+    }
+    return mask;
+}
+
+struct PlayoutResult {
+    int moves;
+    float score;   // Final area score, or the settled bound when stopped early
+    bool settled;  // Stopped because the winner could no longer change
+};
+
+// Playouts only need the winner: once Benson-safe area alone decides the game
+// the rest of the fill-in can be skipped. A check costs two Benson passes
+// (about 20us), which is as much as the 40-50 moves it typically saves, so
+// this is not a speedup today and the check is off by default (checkEvery 0).
+// When enabled it runs every checkEvery moves once the board has at most
+// checkBelow empty points. Assumes neither side fills its own vital regions.
+template <class Rng>
+PlayoutResult playoutUntilSettled(PlayoutBoard& board, Rng& rng, float komi = 7.5f,
+                                  int checkEvery = 0, int checkBelow = 90,
+                                  int maxMoves = 3 * 361) {
+    int played = 0;
+    while (board.passes < 2 && played < maxMoves) {
+        board.play(board.sampleMove(rng));
+        played++;
+
+        if (checkEvery <= 0 || played % checkEvery != 0 || board.numEmpty > checkBelow) continue;
+        Bitboard black = colorMask(board, Pattern::Black);
+        Bitboard white = colorMask(board, Pattern::White);
+        BensonResult b = bensonAlive(black, white);
+        BensonResult w = bensonAlive(white, black);
+        int safeBlack = (b.alive | b.territory).count();
+        int safeWhite = (w.alive | w.territory).count();
+
+        float lowest = 2 * safeBlack - 361 - komi;   // White takes everything unsettled
+        float highest = 361 - 2 * safeWhite - komi;  // Black takes everything unsettled
+        if (lowest > 0)  return { played, lowest, true };
+        if (highest < 0) return { played, highest, true };
+    }
+    return { played, board.score(komi), false };
+}
+
+struct DeadStones {
+    Bitboard black;
+    Bitboard white;
+};
+
+// Dead stones of a finished game: chains that the opponent ends up owning in
+// most of a few playouts, plus anything inside the opponent's Benson territory.
+// Benson-alive chains are never marked dead.
+template <class Rng>
+DeadStones estimateDeadStones(const State& s, Rng& rng, int playouts = 32) {
+    Bitboard black = Bitboard::fromState(s, true);
+    Bitboard white = Bitboard::fromState(s, false);
+    BensonResult blackSafe = bensonAlive(black, white);
+    BensonResult whiteSafe = bensonAlive(white, black);
+
+    std::array<int, 361> ownership{};
+    PlayoutBoard start = PlayoutBoard::fromState(s);
+    for (int i = 0; i < playouts; ++i) {
+        PlayoutBoard board = start;
+        board.playout(rng);
+        for (int p = 0; p < 361; ++p) ownership[p] += board.owner(p);
+    }
+
+    DeadStones dead;
+    dead.black = black & whiteSafe.territory;
+    dead.white = white & blackSafe.territory;
+    for (int c = 0; c < 2; ++c) {
+        const Bitboard& own = c == 0 ? black : white;
+        Bitboard& ownDead = c == 0 ? dead.black : dead.white;
+        for (Bitboard rest = own.andNot((c == 0 ? blackSafe : whiteSafe).alive | ownDead); rest.any();) {
+            Bitboard chain = Bitboard::single(rest.first()).fill(own);
+            rest = rest.andNot(chain);
+            int sum = 0;
+            chain.forEach([&](int p) { sum += ownership[p]; });
+            if (c == 0 ? sum < 0 : sum > 0) ownDead |= chain;
+        }
+    }
+    return dead;
+}
+
+// Area score of a finished game from black's point of view, dead stones removed
+inline float scoreFinished(const State& s, const DeadStones& dead, float komi = 7.5f) {
+    Bitboard black = Bitboard::fromState(s, true).andNot(dead.black);
+    Bitboard white = Bitboard::fromState(s, false).andNot(dead.white);
+    Bitboard empties = Bitboard::board.andNot(black | white);
+
+    int total = black.count() - white.count();
+    for (Bitboard rest = empties; rest.any();) {
+        Bitboard region = Bitboard::single(rest.first()).fill(empties);
+        rest = rest.andNot(region);
+        Bitboard border = region.neighbours();
+        bool touchesBlack = (border & black).any();
+        bool touchesWhite = (border & white).any();
+        if (touchesBlack != touchesWhite) total += touchesBlack ? region.count() : -region.count();
+    }
+    return total - komi;
+}
+
+// MARK: --- Influence and Territory Estimate ---
+// Deterministic estimate for positions still in play, computed entirely on
+// bit planes so each step handles 64 points per word operation. Both colours
+// spread one point per step over empty points, up to maxDistance steps; a
+// point reached by both in the same step stays neutral. An erosion pass then
+// gives up points of each area that touch the other colour's area or stones.
+// Life and death is not read: every stone counts as alive.
+
+struct TerritoryEstimate {
+    Bitboard black;  // Black stones and the points black is estimated to own
+    Bitboard white;
+    float score;     // Area estimate from black's point of view, komi included
+
+    // +1 for black, -1 for white, 0 for neutral
+    int ownership(int p) const { return int(black.test(p)) - int(white.test(p)); }
+
+    std::array<int8_t, 361> ownershipMap() const {
+        std::array<int8_t, 361> map{};
+        black.forEach([&](int p) { map[p] = 1; });
+        white.forEach([&](int p) { map[p] = -1; });
+        return map;
+    }
+};
+
+inline TerritoryEstimate estimateTerritory(const State& s, float komi = 7.5f, int maxDistance = 4) {
+    Bitboard blackStones = Bitboard::fromState(s, true);
+    Bitboard whiteStones = Bitboard::fromState(s, false);
+    Bitboard black = blackStones, white = whiteStones;
+    Bitboard unclaimed = Bitboard::board.andNot(black | white);
+
+    Bitboard blackFront = black, whiteFront = white;
+    for (int step = 0; step < maxDistance; ++step) {
+        Bitboard b = blackFront.neighbours() & unclaimed;
+        Bitboard w = whiteFront.neighbours() & unclaimed;
+        if (!(b | w).any()) break;
+        Bitboard contested = b & w;
+        unclaimed = unclaimed.andNot(b | w);
+        blackFront = b.andNot(contested);
+        whiteFront = w.andNot(contested);
+        black |= blackFront;
+        white |= whiteFront;
+    }
+
+    Bitboard blackArea = black.andNot(blackStones);
+    Bitboard whiteArea = white.andNot(whiteStones);
+    black = black.andNot(whiteStones.neighbours() | (whiteArea.neighbours() & blackArea)) | blackStones;
+    white = white.andNot(blackStones.neighbours() | (blackArea.neighbours() & whiteArea)) | whiteStones;
+
+    return { black, white, black.count() - white.count() - komi };
+}
+
+// Estimates for a batch of positions; out must hold count results
+inline void estimateTerritory(const State* states, size_t count, TerritoryEstimate* out,
+                              float komi = 7.5f, int maxDistance = 4) {
+    for (size_t i = 0; i < count; ++i) out[i] = estimateTerritory(states[i], komi, maxDistance);
+}
+
+// MARK: --- UCT Search with Tree Reuse and Pondering ---
+// Nodes live in a fixed-size arena and every expansion writes all children as
+// one contiguous block. Playing a move copies the chosen child's subtree into a
+// second arena and swaps, which frees everything else at once. While waiting
+// for the opponent the tree keeps growing on a background thread.
+//
+// With `rave` set, every simulation also credits the children of each node on
+// its path whose move the same colour played first later in the simulation
+// (AMAF), and selection blends those statistics in with weight
+// beta = sqrt(k / (3n + k)), k = raveEquivalence.
+
+struct SearchNode {
+    int16_t move;         // Move that led here, PlayoutBoard::kPass for pass
+    uint16_t numChildren;
+    uint32_t firstChild;  // Arena index of the first child
+    uint32_t visits;
+    float wins;           // For the player who made `move`
+    uint32_t raveVisits;
+    float raveWins;
+};
+
+struct UctSearch {
+    static constexpr uint32_t kExpandVisits = 2;
+    static constexpr float kExploration = 0.7f;
+    static constexpr float kFirstPlayUrgency = 0.6f;  // Just above an even result, so good moves get revisited early
+    static constexpr float kRaveExploration = 0.1f;
+
+    PlayoutBoard rootBoard;
+    std::vector<SearchNode> arena;
+    std::vector<SearchNode> spare;  // Destination for subtree copies on advance()
+    size_t used = 0;
+    std::vector<uint32_t> path;
+    std::mt19937 rng;
+    float komi;
+    bool rave = false;
+    float raveEquivalence = 1000.0f;
+
+    std::thread ponderThread;
+    std::atomic<bool> stopPonder{ false };
+
+    // memoryBytes covers both arenas
+    UctSearch(const PlayoutBoard& position, size_t memoryBytes, uint64_t seed = 42, float komi = 7.5f)
+        : arena(std::max<size_t>(memoryBytes / 2 / sizeof(SearchNode), 1)),
+          spare(arena.size()), rng(seed), komi(komi) {
+        path.reserve(1024);
+        setPosition(position);
+    }
+
+    ~UctSearch() { stopPondering(); }
+
+    // setPosition, run, runFor and advance stop pondering first, since the
+    // ponder thread owns the tree while it runs
+    void setPosition(const PlayoutBoard& position) {
+        stopPondering();
+        rootBoard = position;
+        arena[0] = { PlayoutBoard::kPass, 0, 0, 0, 0.0f, 0, 0.0f };
+        used = 1;
+    }
+
+    // Not while pondering: the tree is read without synchronisation
+    const SearchNode& root() const { return arena[0]; }
+
+    void run(int playouts) {
+        stopPondering();
+        for (int i = 0; i < playouts; ++i) iterate();
+    }
+
+    // Searches until `budget` has elapsed; returns the playouts made
+    int runFor(std::chrono::microseconds budget) {
+        stopPondering();
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        int playouts = 0;
+        do {
+            run(16);
+            playouts += 16;
+        } while (std::chrono::steady_clock::now() < deadline);
+        return playouts;
+    }
+
+    // Most visited root child, or pass before the root is expanded. Not while
+    // pondering: call advance() or stopPondering() first.
+    int bestMove() const {
+        const SearchNode& r = arena[0];
+        int best = PlayoutBoard::kPass;
+        uint32_t bestVisits = 0;
+        for (uint32_t i = r.firstChild; i < r.firstChild + r.numChildren; ++i) {
+            if (arena[i].visits > bestVisits) {
+                bestVisits = arena[i].visits;
+                best = arena[i].move;
+            }
+        }
+        return best;
+    }
+
+    // Plays `move` at the root. Returns true if its subtree was kept.
+    bool advance(int move) {
+        stopPondering();
+        const SearchNode& r = arena[0];
+        uint32_t child = 0;
+        for (uint32_t i = r.firstChild; i < r.firstChild + r.numChildren; ++i) {
+            if (arena[i].move == move) child = i;
+        }
+
+        rootBoard.play(move);
+        if (child == 0) {
+            arena[0] = { PlayoutBoard::kPass, 0, 0, 0, 0.0f, 0, 0.0f };
+            used = 1;
+            return false;
+        }
+
+        // Breadth-first copy keeps sibling blocks contiguous
+        std::vector<std::pair<uint32_t, uint32_t>> queue{ { child, 0 } };
+        spare[0] = arena[child];
+        size_t spareUsed = 1;
+        for (size_t q = 0; q < queue.size(); ++q) {
+            auto [from, to] = queue[q];
+            SearchNode& copy = spare[to];
+            if (copy.numChildren == 0) continue;
+            uint32_t first = arena[from].firstChild;
+            copy.firstChild = uint32_t(spareUsed);
+            for (uint32_t i = 0; i < copy.numChildren; ++i) {
+                spare[spareUsed] = arena[first + i];
+                queue.push_back({ first + i, uint32_t(spareUsed) });
+                spareUsed++;
+            }
+        }
+        std::swap(arena, spare);
+        used = spareUsed;
+        return true;
+    }
+
+    void startPondering() {
+        stopPondering();
+        stopPonder = false;
+        ponderThread = std::thread([this] {
+            while (!stopPonder.load(std::memory_order_relaxed)) iterate();
+        });
+    }
+
+    void stopPondering() {
+        if (!ponderThread.joinable()) return;
+        stopPonder = true;
+        ponderThread.join();
+    }
+
+    uint32_t selectChild(uint32_t node) const {
+        const SearchNode& n = arena[node];
+        float logVisits = std::log(float(n.visits) + 1.0f);
+        uint32_t best = n.firstChild;
+        float bestValue = -1.0f;
+        for (uint32_t i = n.firstChild; i < n.firstChild + n.numChildren; ++i) {
+            const SearchNode& c = arena[i];
+            float value;
+            if (rave && c.raveVisits > 0) {
+                float beta = std::sqrt(raveEquivalence / (3.0f * c.visits + raveEquivalence));
+                float mean = c.visits ? c.wins / c.visits : 0.0f;
+                value = (1.0f - beta) * mean + beta * c.raveWins / c.raveVisits
+                      + kRaveExploration * std::sqrt(logVisits / (c.visits + 1));
+            } else {
+                value = c.visits == 0 ? kFirstPlayUrgency
+                    : c.wins / c.visits + kExploration * std::sqrt(logVisits / c.visits);
+            }
+            if (value > bestValue) {
+                bestValue = value;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // Adds every sensible move as a child; fails when the arena is full
+    bool expand(uint32_t node, const PlayoutBoard& board) {
+        std::array<int16_t, 361> moves;
+        int count = 0;
+        for (int p = 0; p < 361; ++p) {
+            if (board.isSensible(p)) moves[count++] = p;
+        }
+        if (count == 0) moves[count++] = PlayoutBoard::kPass;
+        if (used + count > arena.size()) return false;
+
+        arena[node].firstChild = uint32_t(used);
+        arena[node].numChildren = uint16_t(count);
+        for (int i = 0; i < count; ++i) arena[used++] = { moves[i], 0, 0, 0, 0.0f, 0, 0.0f };
+        return true;
+    }
+
+    void iterate() {
+        PlayoutBoard board = rootBoard;
+        path.clear();
+        uint32_t node = 0;
+        path.push_back(node);
+
+        while (arena[node].numChildren > 0) {
+            node = selectChild(node);
+            board.play(arena[node].move);
+            path.push_back(node);
+        }
+        if (arena[node].visits >= kExpandVisits && board.passes < 2 && expand(node, board)) {
+            node = selectChild(node);
+            board.play(arena[node].move);
+            path.push_back(node);
+        }
+
+        AmafRecord amaf;
+        board.playout(rng, 3 * 361, rave ? &amaf : nullptr);
+        bool blackWins = board.score(komi) > 0;
+
+        // The root's child was played by the side to move at the root
+        bool moverIsBlack = !rootBoard.blackToMove;
+        for (uint32_t n : path) {
+            arena[n].visits++;
+            if (moverIsBlack == blackWins) arena[n].wins += 1.0f;
+            moverIsBlack = !moverIsBlack;
+        }
+        if (rave) updateRave(amaf, blackWins);
+    }
+
+    // Walks the path leaf to root so that `amaf` always holds the first plays
+    // made after the current node: tree moves closer to the root overwrite
+    // later plays on the same point.
+    void updateRave(AmafRecord amaf, bool blackWins) {
+        for (size_t i = path.size(); i-- > 0;) {
+            const SearchNode& n = arena[path[i]];
+            bool blackMoves = rootBoard.blackToMove != (i % 2 == 1);
+            const Bitboard& firstPlays = blackMoves ? amaf.black : amaf.white;
+            bool win = blackMoves == blackWins;
+            for (uint32_t c = n.firstChild; c < n.firstChild + n.numChildren; ++c) {
+                SearchNode& child = arena[c];
+                if (child.move < 0 || !firstPlays.test(child.move)) continue;
+                child.raveVisits++;
+                if (win) child.raveWins += 1.0f;
+            }
+
+            // The move into this node was made by the other colour
+            if (i > 0 && n.move >= 0) {
+                (blackMoves ? amaf.white : amaf.black).set(n.move);
+                (blackMoves ? amaf.black : amaf.white).reset(n.move);
+            }
+        }
+    }
+};
+
+// MARK: --- Opening Book ---
+// Move statistics for opening positions, keyed by a canonical position hash
+// so that all 8 rotations and reflections of a position share one entry.
+// Moves are stored in the canonical orientation and mapped back on lookup.
+//
+// File layout, little-endian and read in place through a read-only mmap:
+//   BookHeader
+//   uint32_t directory[2^bucketBits + 1]  first entry of each key bucket
+//   BookEntry entries[numEntries]          sorted by key, then move
+// The bucket is the top bucketBits bits of the key; buckets hold about four
+// entries, so a lookup is one directory read and a short scan.
+
+struct BoardSymmetry {
+    // Symmetry s flips x when bit 0 is set, flips y for bit 1, then swaps x
+    // and y for bit 2
+    static std::array<std::array<int16_t, 361>, 8> initPoints() {
+        std::array<std::array<int16_t, 361>, 8> points;
+        for (int s = 0; s < 8; ++s) {
+            for (int idx = 0; idx < 361; ++idx) {
+                int x = idx % 19, y = idx / 19;
+                if (s & 1) x = 18 - x;
+                if (s & 2) y = 18 - y;
+                if (s & 4) std::swap(x, y);
+                points[s][idx] = x + 19 * y;
+            }
+        }
+        return points;
+    }
+
+    static std::array<std::array<int16_t, 361>, 8> initInverse() {
+        std::array<std::array<int16_t, 361>, 8> inverse;
+        for (int s = 0; s < 8; ++s) {
+            for (int idx = 0; idx < 361; ++idx) inverse[s][point[s][idx]] = idx;
+        }
+        return inverse;
+    }
+
+    static const std::array<std::array<int16_t, 361>, 8> point;
+    static const std::array<std::array<int16_t, 361>, 8> inverse;
+};
+
+const std::array<std::array<int16_t, 361>, 8> BoardSymmetry::point = BoardSymmetry::initPoints();
+const std::array<std::array<int16_t, 361>, 8> BoardSymmetry::inverse = BoardSymmetry::initInverse();
+
+struct CanonicalKey {
+    uint64_t key;
+    int symmetry;  // Maps the position onto its canonical orientation
+
+    int toCanonical(int move) const   { return move < 0 ? move : BoardSymmetry::point[symmetry][move]; }
+    int fromCanonical(int move) const { return move < 0 ? move : BoardSymmetry::inverse[symmetry][move]; }
+};
+
+// Smallest Zobrist hash over the 8 symmetries; ties go to the lowest symmetry.
+// Ties only happen for symmetric positions, where a move and its mirror image
+// are equally good but are counted as separate book moves.
+inline CanonicalKey canonicalKey(const State& s) {
+    std::array<uint64_t, 8> h{};
+    if (s.getTurnState()) h.fill(Zobrist::keys.whiteToMove);
+    for (int c = 0; c < 2; ++c) {
+        Bitboard::fromState(s, c == 0).forEach([&](int idx) {
+            for (int sym = 0; sym < 8; ++sym) h[sym] ^= Zobrist::keys.stone[c][BoardSymmetry::point[sym][idx]];
+        });
+    }
+    CanonicalKey best{h[0], 0};
+    for (int sym = 1; sym < 8; ++sym) {
+        if (h[sym] < best.key) best = {h[sym], sym};
+    }
+    return best;
+}
+
+struct BookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bucketBits;
+    uint64_t numEntries;
+};
+
+struct BookEntry {
+    uint64_t key;
+    int16_t move;       // Canonical orientation, -1 for pass
+    uint16_t reserved;
+    uint32_t plays;
+    uint32_t wins;      // For the side to move
+    uint32_t reserved2;
+};
+
+static_assert(sizeof(BookHeader) == 24 && sizeof(BookEntry) == 24, "book file layout");
+
+struct BookMove {
+    int move;
+    uint32_t plays;
+    uint32_t wins;
+};
+
+// One game: moves as point indices (-1 passes) and the winner, +1 for black,
+// -1 for white, 0 if unknown
+struct GameRecord {
+    std::vector<int16_t> moves;
+    int winner = 0;
+};
+
+// Reads one record per line: the winner (B, W or ?) then the moves, e.g.
+// "B 60 300 -1 72". Returns false at end of stream.
+inline bool readGameRecord(std::istream& in, GameRecord& record) {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string winner;
+        if (!(fields >> winner)) continue;
+        record.winner = winner == "B" ? 1 : winner == "W" ? -1 : 0;
+        record.moves.clear();
+        int move;
+        while (fields >> move) record.moves.push_back(int16_t(move));
+        return true;
+    }
+    return false;
+}
+
+class OpeningBookBuilder {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    explicit OpeningBookBuilder(int maxPly = 30) : maxPly(maxPly) {}
+
+    // Replays the opening of a game; stops early at an illegal move
+    void addGame(const GameRecord& record) {
+        PlayoutBoard board;
+        int plies = std::min<int>(maxPly, record.moves.size());
+        for (int i = 0; i < plies; ++i) {
+            int move = record.moves[i];
+            if (move < PlayoutBoard::kPass || move >= 361 || !board.isLegal(move)) break;
+            CanonicalKey k = canonicalKey(board.toState());
+            int mover = board.blackToMove ? 1 : -1;
+            pending.push_back({k.key, int16_t(k.toCanonical(move)), 0, 1, record.winner == mover ? 1u : 0u, 0});
+            board.play(move);
+        }
+        if (pending.size() >= compactAt) {
+            compact();
+            compactAt = std::max(compactAt, 2 * pending.size());
+        }
+    }
+
+    void addGames(std::istream& in) {
+        GameRecord record;
+        while (readGameRecord(in, record)) addGame(record);
+    }
+
+    // Writes the book, dropping moves seen fewer than minPlays times
+    bool write(const char* path, uint32_t minPlays = 1) {
+        compact();
+        std::vector<BookEntry> entries;
+        for (const BookEntry& e : pending) {
+            if (e.plays >= minPlays) entries.push_back(e);
+        }
+
+        uint32_t bucketBits = 1;
+        while (bucketBits < 30 && (uint64_t(4) << bucketBits) < entries.size()) bucketBits++;
+        std::vector<uint32_t> directory((size_t(1) << bucketBits) + 1);
+        size_t i = 0;
+        for (size_t b = 0; b < directory.size(); ++b) {
+            while (i < entries.size() && (entries[i].key >> (64 - bucketBits)) < b) i++;
+            directory[b] = i;
+        }
+        if (directory.size() % 2) directory.push_back(entries.size());  // Keep entries 8-byte aligned
+
+        BookHeader header{};
+        std::memcpy(header.magic, "GOBOOK\0\0", 8);
+        header.version = kVersion;
+        header.bucketBits = bucketBits;
+        header.numEntries = entries.size();
+
+        FILE* f = std::fopen(path, "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(&header, sizeof header, 1, f) == 1 &&
+                  std::fwrite(directory.data(), sizeof(uint32_t), directory.size(), f) == directory.size() &&
+                  std::fwrite(entries.data(), sizeof(BookEntry), entries.size(), f) == entries.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+private:
+    // Sorts by (key, move) and merges duplicates
+    void compact() {
+        std::sort(pending.begin(), pending.end(), [](const BookEntry& a, const BookEntry& b) {
+            return a.key != b.key ? a.key < b.key : a.move < b.move;
+        });
+        size_t out = 0;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (out > 0 && pending[out - 1].key == pending[i].key && pending[out - 1].move == pending[i].move) {
+                pending[out - 1].plays += pending[i].plays;
+                pending[out - 1].wins += pending[i].wins;
+            } else {
+                pending[out++] = pending[i];
+            }
+        }
+        pending.resize(out);
+    }
+
+    int maxPly;
+    std::vector<BookEntry> pending;  // Merged up to the last compaction
+    size_t compactAt = size_t(1) << 22;
+};
+
+// Read-only view of a book file. The mapping is shared, so every process
+// that opens the same book shares its pages.
+class OpeningBook {
+public:
+    OpeningBook() = default;
+    ~OpeningBook() { close(); }
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(BookHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        base = static_cast<const uint8_t*>(mapped);
+        mappedSize = st.st_size;
+
+        const BookHeader* header = reinterpret_cast<const BookHeader*>(base);
+        if (std::memcmp(header->magic, "GOBOOK\0\0", 8) != 0 || header->version != OpeningBookBuilder::kVersion ||
+            header->bucketBits == 0 || header->bucketBits > 30) {
+            close();
+            return false;
+        }
+        size_t dirSize = (size_t(1) << header->bucketBits) + 1;
+        dirSize += dirSize % 2;
+        if (sizeof(BookHeader) + dirSize * sizeof(uint32_t) + header->numEntries * sizeof(BookEntry) != mappedSize) {
+            close();
+            return false;
+        }
+        bucketBits = header->bucketBits;
+        directory = reinterpret_cast<const uint32_t*>(base + sizeof(BookHeader));
+        entries = reinterpret_cast<const BookEntry*>(directory + dirSize);
+        numEntries = header->numEntries;
+        return true;
+    }
+
+    void close() {
+        if (base) munmap(const_cast<uint8_t*>(base), mappedSize);
+        base = nullptr;
+        mappedSize = 0;
+        numEntries = 0;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+    size_t size() const { return numEntries; }
+
+    // Entries for a canonical key, as a [first, last) range
+    std::pair<const BookEntry*, const BookEntry*> probe(uint64_t key) const {
+        if (!base) return { nullptr, nullptr };
+        uint64_t b = key >> (64 - bucketBits);
+        const BookEntry* first = entries + directory[b];
+        const BookEntry* last = entries + directory[b + 1];
+        while (first < last && first->key < key) ++first;
+        const BookEntry* end = first;
+        while (end < last && end->key == key) ++end;
+        return { first, end };
+    }
+
+    // Fills up to maxMoves book moves for s in its own orientation; returns the count
+    int lookup(const State& s, BookMove* out, int maxMoves) const {
+        CanonicalKey k = canonicalKey(s);
+        auto [first, last] = probe(k.key);
+        int n = 0;
+        for (const BookEntry* e = first; e < last && n < maxMoves; ++e) {
+            out[n++] = { k.fromCanonical(e->move), e->plays, e->wins };
+        }
+        return n;
+    }
+
+    // Most played book move with at least minPlays games, or -2 when out of book
+    int bestMove(const State& s, uint32_t minPlays = 1) const {
+        CanonicalKey k = canonicalKey(s);
+        auto [first, last] = probe(k.key);
+        const BookEntry* best = nullptr;
+        for (const BookEntry* e = first; e < last; ++e) {
+            if (e->plays >= minPlays && (!best || e->plays > best->plays)) best = e;
+        }
+        return best ? k.fromCanonical(best->move) : kOutOfBook;
+    }
+
+    static constexpr int kOutOfBook = -2;
+
+private:
+    const uint8_t* base = nullptr;
+    size_t mappedSize = 0;
+    uint32_t bucketBits = 0;
+    const uint32_t* directory = nullptr;
+    const BookEntry* entries = nullptr;
+    uint64_t numEntries = 0;
+};
+
+// MARK: --- Batched Move Validation ---
+// Checks many (board, move) pairs in one call and reports a verdict and the
+// stones each legal move captures, without touching the boards. The move is
+// for the side to move in each State. Ko cannot be judged here: a State has
+// no history.
+//
+// Requests are visited in order, prefetching the board a few requests ahead,
+// and consecutive moves against the same board share one bit-plane
+// extraction. Sorting requests by board address measured slower: the
+// scattered result writes cost more than the board reads that prefetching
+// already hides. Large batches are split over threads in contiguous chunks.
+
+// Ko is only reported by callers that know the previous move, e.g. GameHistory
+enum class MoveVerdict : uint8_t { Legal, OffBoard, Occupied, Suicide, Ko };
+
+struct MoveRequest {
+    const State* board;
+    int16_t move;  // Point index, -1 to pass
+};
+
+struct MoveValidation {
+    MoveVerdict verdict;
+    Bitboard captured;  // Opponent stones removed by a legal move
+};
+
+inline MoveValidation validateMove(const Bitboard& own, const Bitboard& opp, int move) {
+    MoveValidation result{MoveVerdict::Legal, Bitboard()};
+    if (move == -1) return result;
+    if (move < 0 || move >= 361) {
+        result.verdict = MoveVerdict::OffBoard;
+        return result;
+    }
+    if (own.test(move) || opp.test(move)) {
+        result.verdict = MoveVerdict::Occupied;
+        return result;
+    }
+
+    Bitboard stone = Bitboard::single(move);
+    Bitboard around = stone.neighbours();
+    Bitboard empty = Bitboard::board.andNot(own | opp | stone);
+    Bitboard checked;
+    (around & opp).forEach([&](int q) {
+        if (checked.test(q)) return;
+        Bitboard chain = Bitboard::single(q).fill(opp);
+        checked |= chain;
+        if (!(chain.neighbours() & empty).any()) result.captured |= chain;
+    });
+
+    if (!result.captured.any() && !(around & empty).any()) {
+        Bitboard ownAfter = own | stone;
+        if (!(stone.fill(ownAfter).neighbours() & empty).any()) result.verdict = MoveVerdict::Suicide;
+    }
+    return result;
+}
+
+struct MoveValidator {
+    static constexpr size_t kParallelThreshold = 8192;  // Smaller batches stay on the calling thread
+    static constexpr size_t kPrefetchDistance = 8;
+
+    // out[i] receives the result for requests[i]
+    static void validate(const MoveRequest* requests, size_t count, MoveValidation* out) {
+        size_t threads = std::thread::hardware_concurrency();
+        threads = std::max<size_t>(1, std::min(threads, count / (kParallelThreshold / 4)));
+        if (count < kParallelThreshold || threads == 1) {
+            validateRange(requests, count, out);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        size_t chunk = (count + threads - 1) / threads;
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            size_t n = std::min(chunk, count - begin);
+            workers.emplace_back(validateRange, requests + begin, n, out + begin, kPrefetchDistance);
+        }
+        for (std::thread& t : workers) t.join();
+    }
+
+    // prefetchDistance 0 turns prefetching off, for comparison
+    static void validateRange(const MoveRequest* requests, size_t count, MoveValidation* out,
+                              size_t prefetchDistance = kPrefetchDistance) {
+        const State* current = nullptr;
+        Bitboard own, opp;
+        for (size_t i = 0; i < count; ++i) {
+            if (prefetchDistance > 0 && i + prefetchDistance < count) {
+                const char* ahead = reinterpret_cast<const char*>(requests[i + prefetchDistance].board);
+                __builtin_prefetch(ahead);
+                __builtin_prefetch(ahead + sizeof(State) - 1);  // A State can straddle two lines
+            }
+            const MoveRequest& r = requests[i];
+            if (r.board != current) {
+                current = r.board;
+                bool whiteToMove = current->getTurnState();
+                own = Bitboard::fromState(*current, !whiteToMove);
+                opp = Bitboard::fromState(*current, whiteToMove);
+            }
+            out[i] = validateMove(own, opp, r.move);
+        }
+    }
+};
+
+// MARK: --- Game History with Checkpoints ---
+// Moves are kept as 2-byte point indices, and the full 91-byte State is
+// stored every `interval` moves. Any position is the nearest checkpoint at or
+// before it plus at most interval - 1 replayed moves, each a capture check on
+// bit planes. Memory per move is 2 + 91 / interval bytes; interval 1 stores
+// every position, a large interval approaches a plain move list.
+
+class GameHistory {
+public:
+    static constexpr int kPass = -1;
+
+    explicit GameHistory(const State& start = State(), int interval = 16) : interval(std::max(1, interval)) {
+        checkpoints.push_back(start);
+        tipBlack = Bitboard::fromState(start, true);
+        tipWhite = Bitboard::fromState(start, false);
+        tipWhiteToMove = start.getTurnState();
+    }
+
+    // Appends a move for the side to move; illegal moves, simple ko
+    // recaptures included, are not recorded
+    MoveVerdict push(int move) {
+        Bitboard& own = tipWhiteToMove ? tipWhite : tipBlack;
+        Bitboard& opp = tipWhiteToMove ? tipBlack : tipWhite;
+        MoveValidation v = validateMove(own, opp, move);
+        if (v.verdict != MoveVerdict::Legal) return v.verdict;
+        if (move != kPass && move == tipKo) return MoveVerdict::Ko;
+        tipKo = kPass;
+        if (move != kPass) {
+            own.set(move);
+            opp = opp.andNot(v.captured);
+
+            // A lone stone that took one stone and has that point as its only
+            // liberty can be retaken at once: the opponent may not play there
+            Bitboard stone = Bitboard::single(move);
+            Bitboard empty = Bitboard::board.andNot(tipBlack | tipWhite);
+            if (v.captured.count() == 1 && !(stone.neighbours() & own).any() &&
+                (stone.neighbours() & empty) == v.captured) {
+                tipKo = v.captured.first();
+            }
+        }
+        tipWhiteToMove = !tipWhiteToMove;
+        moves.push_back(int16_t(move));
+        if (moves.size() % interval == 0) checkpoints.push_back(makeState(tipBlack, tipWhite, moves.size()));
+        return v.verdict;
+    }
+
+    // Number of moves; positions run from 0 (the start) to size()
+    size_t size() const { return moves.size(); }
+
+    // The n-th move; n must be below size()
+    int move(size_t n) const {
+        assert(n < moves.size());
+        return moves[n];
+    }
+
+    // Point the side to move may not play because of ko, or kPass
+    int koPoint() const { return tipKo; }
+    int checkpointInterval() const { return interval; }
+
+    size_t memoryBytes() const {
+        return moves.capacity() * sizeof(int16_t) + checkpoints.capacity() * sizeof(State);
+    }
+
+    // Position after the first n moves; n past size() is clamped to the last position
+    State at(size_t n) const {
+        n = std::min(n, moves.size());
+        size_t cp = std::min(n / interval, checkpoints.size() - 1);
+        const State& base = checkpoints[cp];
+        if (n == cp * interval) return base;
+
+        Bitboard black = Bitboard::fromState(base, true);
+        Bitboard white = Bitboard::fromState(base, false);
+        bool whiteToMove = base.getTurnState();
+        for (size_t i = cp * interval; i < n; ++i) {
+            int m = moves[i];
+            if (m != kPass) {
+                Bitboard& own = whiteToMove ? white : black;
+                Bitboard& opp = whiteToMove ? black : white;
+                opp = opp.andNot(validateMove(own, opp, m).captured);
+                own.set(m);
+            }
+            whiteToMove = !whiteToMove;
+        }
+        return makeState(black, white, n);
+    }
+
+private:
+    // Turn follows from the start position and the move count; two passes
+    // in a row end the game, as in the game loop
+    State makeState(const Bitboard& black, const Bitboard& white, size_t n) const {
+        State s;
+        black.addToState(s, true);
+        white.addToState(s, false);
+        s.setTurnState(checkpoints[0].getTurnState() != (n % 2 == 1));
+        bool ended = n >= 2 && moves[n - 1] == kPass && moves[n - 2] == kPass;
+        s.setGameActive(checkpoints[0].getGameActive() && !ended);
+        return s;
+    }
+
+    int interval;
+    std::vector<int16_t> moves;
+    std::vector<State> checkpoints;  // checkpoints[i] is the position after i * interval moves
+    Bitboard tipBlack, tipWhite;
+    bool tipWhiteToMove;
+    int tipKo = kPass;
+};
+
+// MARK: --- NUMA-Aware Worker Pool ---
+// One worker per CPU, pinned to it and grouped by NUMA node. Topology comes
+// from /sys/devices/system/node, cut down to the CPUs this process may run on
+// (taskset, cgroup cpusets), so engines sharing a host never spill onto each
+// other's cores. A worker that cannot be pinned to its CPU is held to its
+// node's CPUs instead, and counted if even that fails. Memory is placed by first touch: each
+// worker builds its own context and board after pinning, and the first
+// worker on each node builds that node's copy of the pattern table, so hot
+// data is local to the socket that reads it. Tasks go to a worker's queue;
+// an idle worker takes the newest task from its own queue and otherwise
+// steals the oldest from workers on the same node, never across nodes.
+
+struct NumaTopology {
+    std::vector<std::vector<int>> nodeCpus;  // CPUs of each node
+
+    // Parses a sysfs cpulist such as "0-3,8-11"
+    static std::vector<int> parseCpuList(const std::string& list) {
+        std::vector<int> cpus;
+        std::istringstream in(list);
+        std::string range;
+        while (std::getline(in, range, ',')) {
+            if (range.empty() || range == "\n") continue;
+            int first = std::stoi(range), last = first;
+            size_t dash = range.find('-');
+            if (dash != std::string::npos) last = std::stoi(range.substr(dash + 1));
+            for (int c = first; c <= last; ++c) cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    static std::string readLine(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    // CPUs in this process's affinity mask; every CPU if it cannot be read
+    static std::vector<int> allowedCpus() {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; ++c) {
+                if (CPU_ISSET(c, &set)) cpus.push_back(c);
+            }
+        }
+        if (cpus.empty()) {
+            int n = std::max(1u, std::thread::hardware_concurrency());
+            for (int c = 0; c < n; ++c) cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    // Online nodes, each cut down to the allowed CPUs; nodes left empty are
+    // dropped. Falls back to a single node of the allowed CPUs when sysfs has
+    // no node list.
+    static NumaTopology detect() {
+        std::vector<int> allowed = allowedCpus();
+        NumaTopology topology;
+        for (int node : parseCpuList(readLine("/sys/devices/system/node/online"))) {
+            std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+            std::vector<int> cpus;
+            for (int c : parseCpuList(readLine(path))) {
+                if (std::binary_search(allowed.begin(), allowed.end(), c)) cpus.push_back(c);
+            }
+            if (!cpus.empty()) topology.nodeCpus.push_back(cpus);
+        }
+        if (topology.nodeCpus.empty()) topology.nodeCpus.push_back(allowed);
+        return topology;
+    }
+
+    int numNodes() const { return nodeCpus.size(); }
+};
+
+// State owned by one worker, allocated on its node
+struct WorkerContext {
+    int index;
+    int cpu;
+    int node;
+    const PatternTable* table;  // This node's copy
+    PlayoutBoard board;
+    Xoshiro256pp rng;
+    bool pinned = true;  // Held to its CPU or at least its node's CPUs
+    uint64_t tasksRun = 0;
+    uint64_t tasksStolen = 0;
+};
+
+class WorkerPool {
+public:
+    using Task = std::function<void(WorkerContext&)>;
+
+    // workersPerNode = 0 starts one worker per CPU
+    explicit WorkerPool(const NumaTopology& topology, const PatternTable* table = nullptr, int workersPerNode = 0)
+        : topology(topology), nodeTables(topology.numNodes()), nodeQueued(topology.numNodes()) {
+        for (int node = 0; node < topology.numNodes(); ++node) {
+            const std::vector<int>& cpus = topology.nodeCpus[node];
+            int n = workersPerNode > 0 ? workersPerNode : cpus.size();
+            std::vector<int> members;
+            for (int i = 0; i < n; ++i) {
+                members.push_back(workers.size());
+                workers.push_back(std::make_unique<Worker>());
+                workers.back()->cpu = cpus[i % cpus.size()];
+                workers.back()->node = node;
+            }
+            nodeWorkers.push_back(members);
+        }
+
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i]->thread = std::thread(&WorkerPool::run, this, int(i), table);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return started == workers.size(); });
+    }
+
+    ~WorkerPool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w->thread.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int numNodes() const { return topology.numNodes(); }
+    int numWorkers() const { return workers.size(); }
+    const std::vector<int>& workersOnNode(int node) const { return nodeWorkers[node]; }
+    const WorkerContext& context(int worker) const { return *workers[worker]->context; }
+    const PatternTable* tableOnNode(int node) const { return nodeTables[node].get(); }
+
+    // Workers the OS would not hold on their node, e.g. a CPU outside the
+    // affinity mask of a hand-built topology; they run wherever it puts them
+    int unpinnedWorkers() const {
+        int n = 0;
+        for (const auto& w : workers) n += !w->context->pinned;
+        return n;
+    }
+
+    // Queues a task on a worker, round-robin over all workers
+    void submit(Task task) {
+        submitTo(nextWorker++ % workers.size(), std::move(task));
+    }
+
+    // Queues a task on a node, round-robin over its workers
+    void submit(int node, Task task) {
+        const std::vector<int>& members = nodeWorkers[node];
+        submitTo(members[nextWorker++ % members.size()], std::move(task));
+    }
+
+    void submitTo(int worker, Task task) {
+        pending.fetch_add(1);
+        {
+            // Counted before it is visible, so a worker never takes an uncounted task
+            std::lock_guard<std::mutex> lock(mutex);
+            nodeQueued[workers[worker]->node]++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(workers[worker]->queueMutex);
+            workers[worker]->queue.push_back(std::move(task));
+        }
+        wake.notify_all();
+    }
+
+    // Blocks until every submitted task has finished
+    void wait() { waitAtMost(0); }
+
+    // Blocks until at most n tasks are queued or running, e.g. to bound the
+    // work a producer has in flight. One waiting thread at a time.
+    void waitAtMost(size_t n) {
+        std::unique_lock<std::mutex> lock(mutex);
+        waitLimit = n;
+        done.wait(lock, [&] { return pending.load() <= n; });
+        waitLimit = 0;
+    }
+
+private:
+    struct Worker {
+        int cpu = 0;
+        int node = 0;
+        std::thread thread;
+        std::unique_ptr<WorkerContext> context;
+        std::mutex queueMutex;
+        std::deque<Task> queue;
+    };
+
+    static bool pinTo(const std::vector<int>& cpus) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus) {
+            if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+        }
+        return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    void run(int index, const PatternTable* table) {
+        Worker& self = *workers[index];
+        bool pinned = pinTo({ self.cpu }) || pinTo(topology.nodeCpus[self.node]);
+
+        // The first worker of a node copies the table while pinned there
+        if (table && nodeWorkers[self.node][0] == index) {
+            nodeTables[self.node] = std::make_unique<PatternTable>(*table);
+            std::lock_guard<std::mutex> lock(mutex);
+            nodeReady++;
+        }
+        wake.notify_all();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return !table || nodeReady == topology.numNodes(); });
+        }
+        const PatternTable* local = nodeTables[self.node].get();
+        self.context.reset(new WorkerContext{index, self.cpu, self.node, local, PlayoutBoard(local),
+                                             Xoshiro256pp(index + 1), pinned});
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            started++;
+        }
+        wake.notify_all();
+
+        for (;;) {
+            Task task;
+            bool stolen = false;
+            if (!take(self, task, stolen)) {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || nodeQueued[self.node] > 0; });
+                if (stopping && nodeQueued[self.node] == 0) return;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                nodeQueued[self.node]--;
+            }
+            task(*self.context);
+            self.context->tasksRun++;
+            self.context->tasksStolen += stolen;
+            if (pending.fetch_sub(1) - 1 <= waitLimit.load()) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+
+    // Newest task of our own queue, else the oldest task of a node sibling
+    bool take(Worker& self, Task& task, bool& stolen) {
+        {
+            std::lock_guard<std::mutex> lock(self.queueMutex);
+            if (!self.queue.empty()) {
+                task = std::move(self.queue.back());
+                self.queue.pop_back();
+                return true;
+            }
+        }
+        for (int other : nodeWorkers[self.node]) {
+            Worker& victim = *workers[other];
+            if (&victim == &self) continue;
+            std::lock_guard<std::mutex> lock(victim.queueMutex);
+            if (!victim.queue.empty()) {
+                task = std::move(victim.queue.front());
+                victim.queue.pop_front();
+                stolen = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    NumaTopology topology;
+    std::vector<std::unique_ptr<PatternTable>> nodeTables;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::vector<int>> nodeWorkers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    size_t started = 0;
+    int nodeReady = 0;
+    std::vector<size_t> nodeQueued;  // Tasks in each node's queues
+    bool stopping = false;
+    std::atomic<size_t> pending{0};  // Queued or running
+    std::atomic<size_t> waitLimit{0};
+    std::atomic<size_t> nextWorker{0};
+};
+
+// Scores of `count` playouts from `start` on the pool. Playout i draws from
+// Xoshiro256pp(seed, i), so the scores are the same for any number of workers.
+inline std::vector<float> runPlayouts(WorkerPool& pool, const PlayoutBoard& start, size_t count, uint64_t seed,
+                                      size_t chunk = 16) {
+    std::vector<float> scores(count);
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        size_t end = std::min(count, begin + chunk);
+        pool.submit([&, begin, end](WorkerContext& ctx) {
+            for (size_t i = begin; i < end; ++i) {
+                Xoshiro256pp rng(seed, i);
+                ctx.board = start;
+                ctx.board.playout(rng);
+                scores[i] = ctx.board.score();
+            }
+        });
+    }
+    pool.wait();
+    return scores;
+}
+
+// MARK: --- Multi-Process Self-Play ---
+// A coordinator forks worker processes, each connected by a Unix socket
+// pair. Messages are fixed-size structs holding the flat 91-byte State, so
+// they go over the socket as they are in memory: coordinator and workers are
+// the same binary. Jobs go out in batches and each worker answers a batch
+// with one write. A worker that dies is replaced and its outstanding jobs
+// are sent again, so a crash costs only the games in flight. If a
+// replacement cannot be started the survivors take over its jobs, and run()
+// fails only once no worker is left.
+
+struct SelfPlayJob {
+    uint32_t id;
+    uint32_t seed;
+    State position;  // Game starts here, side to move from the turn bit
+};
+
+struct SelfPlayResult {
+    uint32_t id;
+    uint32_t moves;
+    float score;     // Area score from black's point of view
+    State position;  // Final position
+};
+
+static_assert(std::is_trivially_copyable<SelfPlayJob>::value && std::is_trivially_copyable<SelfPlayResult>::value,
+              "self-play messages are sent as raw bytes");
+
+class SelfPlayCoordinator {
+public:
+    SelfPlayCoordinator(int numWorkers, const PatternTable* table = nullptr, float komi = 7.5f)
+        : table(table), komi(komi), workers(std::max(1, numWorkers)) {
+        for (size_t i = 0; i < workers.size(); ++i) spawn(i);
+    }
+
+    ~SelfPlayCoordinator() {
+        for (size_t i = 0; i < workers.size(); ++i) stop(i);
+    }
+
+    SelfPlayCoordinator(const SelfPlayCoordinator&) = delete;
+    SelfPlayCoordinator& operator=(const SelfPlayCoordinator&) = delete;
+
+    int numWorkers() const { return workers.size(); }
+    pid_t workerPid(int i) const { return workers[i].pid; }
+    int restarts() const { return numRestarts; }
+
+    // Coordinator time outside poll(): sending, receiving and bookkeeping
+    std::chrono::nanoseconds busyTime() const { return busy; }
+
+    // Runs every job and fills results in job order. Returns false, with
+    // results incomplete, when no worker process could be kept running.
+    bool run(const std::vector<SelfPlayJob>& jobs, std::vector<SelfPlayResult>& results, size_t batchSize = 8) {
+        results.assign(jobs.size(), SelfPlayResult());
+        std::vector<bool> finished(jobs.size(), false);
+        std::deque<uint32_t> queue;
+        for (uint32_t i = 0; i < jobs.size(); ++i) queue.push_back(i);
+        size_t remaining = jobs.size();
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds waiting{0};
+
+        // Slots whose last spawn failed get one more try per run
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (workers[i].fd < 0) spawn(i);
+        }
+        feedIdle(jobs, queue, batchSize);
+
+        std::vector<pollfd> fds(workers.size());
+        bool ok = true;
+        while (remaining > 0) {
+            bool anyAlive = false;
+            for (size_t i = 0; i < workers.size(); ++i) {
+                fds[i] = { workers[i].fd, POLLIN, 0 };
+                anyAlive |= workers[i].fd >= 0;
+            }
+            if (!anyAlive) {
+                ok = false;  // Every worker died and none could be restarted
+                break;
+            }
+            auto before = std::chrono::steady_clock::now();
+            int ready = poll(fds.data(), fds.size(), -1);
+            waiting += std::chrono::steady_clock::now() - before;
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                ok = false;
+                break;
+            }
+
+            for (size_t i = 0; i < workers.size(); ++i) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                Worker& w = workers[i];
+                if (!receive(w)) {
+                    // Worker gone: resend what it held and start a replacement
+                    for (uint32_t slot : w.outstanding) queue.push_front(slot);
+                    stop(i);
+                    numRestarts += spawn(i);
+                    feedIdle(jobs, queue, batchSize);
+                    continue;
+                }
+
+                size_t complete = w.inbox.size() / sizeof(SelfPlayResult);
+                for (size_t k = 0; k < complete; ++k) {
+                    SelfPlayResult r;
+                    std::memcpy(&r, w.inbox.data() + k * sizeof r, sizeof r);
+                    auto slot = std::find(w.outstanding.begin(), w.outstanding.end(), r.id);
+                    if (slot == w.outstanding.end()) continue;
+                    w.outstanding.erase(slot);
+                    if (!finished[r.id]) {
+                        finished[r.id] = true;
+                        results[r.id] = r;
+                        results[r.id].id = jobs[r.id].id;
+                        remaining--;
+                    }
+                }
+                w.inbox.erase(w.inbox.begin(), w.inbox.begin() + complete * sizeof(SelfPlayResult));
+                if (w.outstanding.empty()) sendBatch(i, jobs, queue, batchSize);
+            }
+        }
+        busy += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start - waiting);
+        return ok;
+    }
+
+private:
+    struct Worker {
+        pid_t pid = -1;
+        int fd = -1;
+        std::vector<uint32_t> outstanding;  // Job slots sent and not yet answered
+        std::vector<uint8_t> inbox;         // Partial results
+    };
+
+    // Leaves the slot with fd -1 when socketpair or fork fails
+    bool spawn(size_t i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return false;
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(sv[0]);
+            for (const Worker& other : workers) {
+                if (other.fd >= 0) close(other.fd);
+            }
+            workerLoop(sv[1]);
+            _exit(0);
+        }
+        close(sv[1]);
+        if (pid < 0) {
+            close(sv[0]);
+            return false;
+        }
+        workers[i] = Worker();
+        workers[i].pid = pid;
+        workers[i].fd = sv[0];
+        return true;
+    }
+
+    // Closing the socket tells the worker to exit
+    void stop(size_t i) {
+        Worker& w = workers[i];
+        if (w.fd >= 0) close(w.fd);
+        if (w.pid > 0) waitpid(w.pid, nullptr, 0);
+        w = Worker();
+    }
+
+    // Gives a batch to every running worker that holds no jobs, so requeued
+    // jobs are not left waiting on a worker that may never answer again
+    void feedIdle(const std::vector<SelfPlayJob>& jobs, std::deque<uint32_t>& queue, size_t batchSize) {
+        for (size_t i = 0; i < workers.size() && !queue.empty(); ++i) {
+            if (workers[i].outstanding.empty()) sendBatch(i, jobs, queue, batchSize);
+        }
+    }
+
+    // Jobs stay queued when the slot has no running worker
+    void sendBatch(size_t i, const std::vector<SelfPlayJob>& jobs, std::deque<uint32_t>& queue, size_t batchSize) {
+        Worker& w = workers[i];
+        if (w.fd < 0) return;
+        std::vector<SelfPlayJob> batch;
+        while (!queue.empty() && batch.size() < batchSize) {
+            uint32_t slot = queue.front();
+            queue.pop_front();
+            batch.push_back(jobs[slot]);
+            batch.back().id = slot;  // Workers echo the slot; the caller's id is restored on return
+            w.outstanding.push_back(slot);
+        }
+        // A failed write shows up as a dead worker at the next poll
+        if (!batch.empty()) writeAll(w.fd, batch.data(), batch.size() * sizeof(SelfPlayJob));
+    }
+
+    bool receive(Worker& w) {
+        uint8_t buffer[64 * sizeof(SelfPlayResult)];
+        ssize_t n;
+        do {
+            n = recv(w.fd, buffer, sizeof buffer, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return false;
+        w.inbox.insert(w.inbox.end(), buffer, buffer + n);
+        return true;
+    }
+
+    static bool writeAll(int fd, const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    // Child process: play every job of a batch, then answer with one write
+    void workerLoop(int fd) {
+        std::vector<uint8_t> inbox;
+        uint8_t buffer[64 * sizeof(SelfPlayJob)];
+        for (;;) {
+            ssize_t n = recv(fd, buffer, sizeof buffer, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            inbox.insert(inbox.end(), buffer, buffer + n);
+
+            size_t complete = inbox.size() / sizeof(SelfPlayJob);
+            std::vector<SelfPlayResult> out(complete);
+            for (size_t k = 0; k < complete; ++k) {
+                SelfPlayJob job;
+                std::memcpy(&job, inbox.data() + k * sizeof job, sizeof job);
+                PlayoutBoard board = PlayoutBoard::fromState(job.position, table);
+                Xoshiro256pp rng(job.seed);
+                out[k].id = job.id;
+                out[k].moves = board.playout(rng);
+                out[k].score = board.score(komi);
+                out[k].position = board.toState();
+            }
+            inbox.erase(inbox.begin(), inbox.begin() + complete * sizeof(SelfPlayJob));
+            if (complete && !writeAll(fd, out.data(), out.size() * sizeof(SelfPlayResult))) return;
+        }
+    }
+
+    const PatternTable* table;
+    float komi;
+    std::vector<Worker> workers;
+    int numRestarts = 0;
+    std::chrono::nanoseconds busy{0};
+};
+
+// MARK: --- Corpus Analytics ---
+// Replays a stream of game records on the worker pool. The reader thread
+// parses games into chunks and hands each chunk to a worker; every worker
+// folds its games into its own accumulator, and the accumulators are merged
+// once the stream ends, so workers share nothing while they run.
+//
+// An accumulator is any copyable type with
+//   void beginGame();
+//   void onMove(const PlayoutBoard& board, int move, int captured);
+//   void endGame(bool complete);
+//   void merge(const Accumulator& other);
+// onMove sees the position after each move. CorpusStats is the stock one.
+
+struct CorpusStats {
+    enum : unsigned { Captures = 1, GroupSizes = 2, Ko = 4, Liberties = 8, All = 15 };
+    static constexpr int kBuckets = 33;  // 0-31 exact, the last bucket counts 32 and up
+
+    unsigned enabled = All;
+
+    uint64_t games = 0;
+    uint64_t incompleteGames = 0;  // Stopped at an illegal move
+    uint64_t positions = 0;
+    uint64_t passes = 0;
+
+    uint64_t captureMoves = 0;
+    uint64_t capturedStones = 0;
+    std::array<uint64_t, kBuckets> captureSizes{};    // Stones taken by one move
+
+    std::array<uint64_t, kBuckets> groupSizes{};      // Chains by stone count, summed over positions
+    std::array<uint64_t, kBuckets> groupLiberties{};  // Chains by liberty count, summed over positions
+
+    uint64_t koCaptures = 0;    // Captures that leave a ko
+    uint64_t koFightGames = 0;  // Games with two or more ko captures
+    int gameKoCaptures = 0;
+
+    explicit CorpusStats(unsigned enabled = All) : enabled(enabled) {}
+
+    static int bucket(int n) { return std::min(n, kBuckets - 1); }
+
+    void beginGame() { gameKoCaptures = 0; }
+
+    void onMove(const PlayoutBoard& board, int move, int captured) {
+        positions++;
+        if (move == PlayoutBoard::kPass) {
+            passes++;
+            return;
+        }
+        if ((enabled & Captures) && captured > 0) {
+            captureMoves++;
+            capturedStones += captured;
+            captureSizes[bucket(captured)]++;
+        }
+        if ((enabled & Ko) && board.koPoint != PlayoutBoard::kPass) {
+            koCaptures++;
+            gameKoCaptures++;
+        }
+        if (enabled & (GroupSizes | Liberties)) countChains(board);
+    }
+
+    void endGame(bool complete) {
+        games++;
+        incompleteGames += !complete;
+        koFightGames += gameKoCaptures >= 2;
+    }
+
+    void merge(const CorpusStats& o) {
+        games += o.games;
+        incompleteGames += o.incompleteGames;
+        positions += o.positions;
+        passes += o.passes;
+        captureMoves += o.captureMoves;
+        capturedStones += o.capturedStones;
+        koCaptures += o.koCaptures;
+        koFightGames += o.koFightGames;
+        for (int i = 0; i < kBuckets; ++i) {
+            captureSizes[i] += o.captureSizes[i];
+            groupSizes[i] += o.groupSizes[i];
+            groupLiberties[i] += o.groupLiberties[i];
+        }
+    }
+
+    // Exact liberties: the board only tracks pseudo-liberties
+    void countChains(const PlayoutBoard& board) {
+        std::array<uint16_t, 361> seenBy{};
+        uint16_t mark = 0;
+        for (int p = 0; p < 361; ++p) {
+            if (board.color[p] == Pattern::Empty || board.head[p] != p) continue;
+            if (enabled & GroupSizes) groupSizes[bucket(board.chainSize[p])]++;
+            if (!(enabled & Liberties)) continue;
+            ++mark;
+            int liberties = 0;
+            int s = p;
+            do {
+                for (int d = 0; d < 4; ++d) {
+                    int q = PlayoutBoard::nbr8[s][d];
+                    if (q >= 0 && board.color[q] == Pattern::Empty && seenBy[q] != mark) {
+                        seenBy[q] = mark;
+                        liberties++;
+                    }
+                }
+                s = board.next[s];
+            } while (s != p);
+            groupLiberties[bucket(liberties)]++;
+        }
+    }
+};
+
+// Replays one game into an accumulator; stops at the first illegal move
+template <class Accumulator>
+void replayGame(const GameRecord& record, Accumulator& acc) {
+    PlayoutBoard board;
+    acc.beginGame();
+    bool complete = true;
+    for (int move : record.moves) {
+        if (move < PlayoutBoard::kPass || move >= 361 || !board.isLegal(move)) {
+            complete = false;
+            break;
+        }
+        int emptyBefore = board.numEmpty;
+        board.play(move);
+        int captured = move == PlayoutBoard::kPass ? 0 : board.numEmpty - (emptyBefore - 1);
+        acc.onMove(board, move, captured);
+    }
+    acc.endGame(complete);
+}
+
+// Streams every game of `in` through the pool. Each worker starts from a copy
+// of `prototype`, which carries the configuration. At most two chunks per
+// worker are in flight, so memory stays bounded whatever the corpus size.
+template <class Accumulator>
+Accumulator analyzeCorpus(std::istream& in, WorkerPool& pool, const Accumulator& prototype = Accumulator(),
+                          size_t chunkGames = 64) {
+    std::vector<Accumulator> locals(pool.numWorkers(), prototype);
+    auto chunk = std::make_shared<std::vector<GameRecord>>();
+    auto dispatch = [&] {
+        pool.waitAtMost(2 * pool.numWorkers());
+        pool.submit([&locals, games = std::move(chunk)](WorkerContext& ctx) {
+            for (const GameRecord& record : *games) replayGame(record, locals[ctx.index]);
+        });
+        chunk = std::make_shared<std::vector<GameRecord>>();
+    };
+
+    GameRecord record;
+    while (readGameRecord(in, record)) {
+        chunk->push_back(record);
+        if (chunk->size() == chunkGames) dispatch();
+    }
+    if (!chunk->empty()) dispatch();
+    pool.wait();
+
+    Accumulator total = prototype;
+    for (const Accumulator& local : locals) total.merge(local);
+    return total;
+}
+
+#ifdef RUN_BENCHMARKS
+
+// MARK: --- Google Benchmark Code ---
+
+// Benchmark basic stone operations
+static void BM_StonePlacement(benchmark::State& state) {
+    State go_state;
+    int position = 180; // Center of board
+    
+    for (auto _ : state) {
+        go_state.setBlack(position, true);
+        go_state.setBlack(position, false); // Reset for next iteration
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StonePlacement);
+
+static void BM_StoneRetrieval(benchmark::State& state) {
+    State go_state;
+    go_state.setBlack(180, true);
+    
+    for (auto _ : state) {
+        bool stone = go_state.getBlack(180);
+        benchmark::DoNotOptimize(stone);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StoneRetrieval);
+
+// Benchmark different board positions
+static void BM_StonesByPosition(benchmark::State& state) {
+    State go_state;
+    int position = state.range(0);
+    
+    for (auto _ : state) {
+        if (go_state.isEmpty(position)) {
+            go_state.setBlack(position, true);
+            go_state.setBlack(position, false);
+        }
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StonesByPosition)->Arg(0)->Arg(18)->Arg(180)->Arg(342)->Arg(360); // Corners, center, edges
+
+// Benchmark liberty counting
+static void BM_LibertyCount(benchmark::State& state) {
+    State go_state;
+    
+    // Set up a test pattern with varying liberty counts
+    go_state.setBlack(180, true); // Center - should have 4 liberties initially
+    go_state.setBlack(181, true); // Adjacent
+    go_state.setBlack(199, true); // Adjacent
+    
+    for (auto _ : state) {
+        int liberties = go_state.countLiberties(180, true);
+        benchmark::DoNotOptimize(liberties);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LibertyCount);
+
+// Benchmark fast liberty check
+static void BM_HasLiberties(benchmark::State& state) {
+    State go_state;
+    
+    // Set up a test pattern
+    go_state.setBlack(180, true);
+    go_state.setBlack(181, true);
+    
+    for (auto _ : state) {
+        bool hasLibs = go_state.hasLiberties(180, true);
+        benchmark::DoNotOptimize(hasLibs);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HasLiberties);
+
+// Benchmark capture detection
+static void BM_CaptureDetection(benchmark::State& state) {
+    State go_state;
+    
+    // Set up a capture scenario - white stone surrounded
+    go_state.setWhite(180, true); // Center stone
+    go_state.setBlack(179, true); // Left
+    go_state.setBlack(181, true); // Right
+    go_state.setBlack(161, true); // Up
+    // Leave bottom (199) open for the capturing move
+    
+    for (auto _ : state) {
+        int captured = go_state.checkAndProcessCaptures(199, true);
+        benchmark::DoNotOptimize(captured);
+        
+        // Reset the captured stone for next iteration
+        if (captured > 0) {
+            go_state.setWhite(180, true);
+        }
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CaptureDetection);
+
+// Benchmark suicide move detection
+static void BM_SuicideDetection(benchmark::State& state) {
+    State go_state;
+    
+    // Set up scenario where placing a stone would be suicide
+    go_state.setWhite(179, true); // Left
+    go_state.setWhite(181, true); // Right
+    go_state.setWhite(161, true); // Up
+    go_state.setWhite(199, true); // Down
+    // Center (180) would be suicide for black
+    
+    for (auto _ : state) {
+        bool isSuicide = go_state.isSuicideMove(180, true);
+        benchmark::DoNotOptimize(isSuicide);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SuicideDetection);
+
+// Benchmark neighbor calculation
+static void BM_GetNeighbors(benchmark::State& state) {
+    State go_state;
+    int position = state.range(0);
+    
+    for (auto _ : state) {
+        const std::vector<int>& neighbors = go_state.getNeighbors(position);
+        benchmark::DoNotOptimize(neighbors);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetNeighbors)->Arg(0)->Arg(18)->Arg(180)->Arg(342)->Arg(360); // Different positions
+
+// Benchmark group finding
+static void BM_GetGroup(benchmark::State& state) {
+    State go_state;
+    
+    // Create a group of connected stones
+    std::vector<int> positions = {180, 181, 182, 199, 200, 201};
+    for (int pos : positions) {
+        go_state.setBlack(pos, true);
+    }
+    
+    for (auto _ : state) {
+        std::vector<int> group = go_state.getGroup(180, true);
+        benchmark::DoNotOptimize(group);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetGroup);
+
+// Benchmark full move sequence
+static void BM_FullMoveSequence(benchmark::State& state) {
+    for (auto _ : state) {
+        State go_state;
+        
+        // Play a sequence of moves
+        go_state.setBlack(180, true);  // Center
+        go_state.setWhite(181, true);  // Adjacent
+        go_state.setBlack(199, true);  // Adjacent to center
+        go_state.setWhite(200, true);  // Adjacent to previous white
+        
+        benchmark::DoNotOptimize(go_state);
+    }
+    
+    state.SetItemsProcessed(state.iterations() * 4); // 4 moves per iteration
+}
+BENCHMARK(BM_FullMoveSequence);
+
+// Memory and state management benchmarks
+static void BM_StateCreation(benchmark::State& state) {
+    for (auto _ : state) {
+        State go_state;
+        benchmark::DoNotOptimize(go_state);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sizeof(State));
+}
+BENCHMARK(BM_StateCreation);
+
+static void BM_StateCopy(benchmark::State& state) {
+    State original;
+    original.setBlack(180, true);
+    original.setWhite(181, true);
+    
+    for (auto _ : state) {
+        State copy = original;
+        benchmark::DoNotOptimize(copy);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sizeof(State));
+}
+BENCHMARK(BM_StateCopy);
+
+// Benchmark game simulation
+static void BM_GameSimulation(benchmark::State& state) {
+    for (auto _ : state) {
+        State go_state;
+        std::mt19937 gen(42); // Fixed seed for reproducibility
+        std::uniform_int_distribution<> dist(0, 360);
+        
+        int moves = 0;
+        int max_moves = state.range(0);
+        
+        while (moves < max_moves) {
+            int pos = dist(gen);
+            if (go_state.isEmpty(pos)) {
+                if (moves % 2 == 0) {
+                    go_state.setBlack(pos, true);
+                } else {
+                    go_state.setWhite(pos, true);
+                }
+                moves++;
+            }
+        }
+        
+        benchmark::DoNotOptimize(go_state);
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GameSimulation)->Arg(10)->Arg(50)->Arg(100);
+
+// Custom counter example
+static void BM_WithCustomCounters(benchmark::State& state) {
+    State go_state;
+    size_t stones_placed = 0;
+    size_t captures = 0;
+    
+    for (auto _ : state) {
+        int pos = stones_placed % 361;
+        if (go_state.isEmpty(pos)) {
+            go_state.setBlack(pos, true);
+            stones_placed++;
+        }
+    }
+    
+    state.counters["StonesPlaced"] = stones_placed;
+    state.counters["StonesPerSecond"] = benchmark::Counter(
+        stones_placed, benchmark::Counter::kIsRate);
+    state.counters["MemoryUsage"] = sizeof(State);
+}
+BENCHMARK(BM_WithCustomCounters);
+
+// Benchmark full random playouts from an empty board, uniform vs pattern-weighted
+static void BM_PlayoutUniform(benchmark::State& state) {
+    std::mt19937 gen(42);
+    size_t moves = 0;
+    
+    for (auto _ : state) {
+        PlayoutBoard board;
+        moves += board.playout(gen);
+        benchmark::DoNotOptimize(board);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["MovesPerPlayout"] = double(moves) / state.iterations();
+    state.counters["MovesPerSecond"] = benchmark::Counter(moves, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_PlayoutUniform);
+
+static void BM_PlayoutPatterns(benchmark::State& state) {
+    static const PatternTable table = PatternTable::defaults();
+    std::mt19937 gen(42);
+    size_t moves = 0;
+    
+    for (auto _ : state) {
+        PlayoutBoard board(&table);
+        moves += board.playout(gen);
+        benchmark::DoNotOptimize(board);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["MovesPerPlayout"] = double(moves) / state.iterations();
+    state.counters["MovesPerSecond"] = benchmark::Counter(moves, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_PlayoutPatterns);
+
+// Ladder test positions: a black stone in atari at (17,1) that runs diagonally
+// to the far corner. 0 = working ladder, 1 = ladder breaker on the path,
+// 2 = prey with two liberties so the attacker chooses the atari.
+static State makeLadderPosition(int which) {
+    State go_state;
+    auto put = [&](int x, int y, bool isBlack) {
+        int bitIndex = (isBlack ? 0 : 361) + x + 19 * y;
+        go_state.data[bitIndex / 8] |= (1 << (bitIndex % 8));
+    };
+    
+    put(17, 1, true);
+    if (which != 2) put(16, 1, false);
+    put(17, 0, false);
+    put(18, 2, false);
+    put(18, 1, false);
+    if (which == 1) put(6, 12, true);
+    return go_state;
+}
+
+// Benchmark a cold ladder read (cache cleared outside the timed region)
+static void BM_LadderRead(benchmark::State& state) {
+    State position = makeLadderPosition(state.range(0));
+    LadderReader reader(10);
+    int verdict = 0;
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        reader.clearCache();
+        reader.nodes = 0;
+        state.ResumeTiming();
+        
+        verdict = reader.read(position, 17 + 19 * 1);
+        benchmark::DoNotOptimize(verdict);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["Verdict"] = verdict;
+    state.counters["Nodes"] = reader.nodes;
+}
+BENCHMARK(BM_LadderRead)->Arg(0)->Arg(1)->Arg(2); // Captured, broken, attacker to move
+
+// Benchmark repeated reads of the same ladder answered from the cache
+static void BM_LadderReadCached(benchmark::State& state) {
+    State position = makeLadderPosition(0);
+    LadderReader reader;
+    reader.setPosition(position);
+    reader.read(17 + 19 * 1);
+    
+    for (auto _ : state) {
+        int verdict = reader.read(17 + 19 * 1);
+        benchmark::DoNotOptimize(verdict);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LadderReadCached);
+
+// Benchmark Benson's algorithm on the final position of a random playout
+static void BM_BensonAlive(benchmark::State& state) {
+    std::mt19937 gen(7);
+    PlayoutBoard board;
+    board.playout(gen);
+    Bitboard black = colorMask(board, Pattern::Black);
+    Bitboard white = colorMask(board, Pattern::White);
+    int alive = 0;
+    
+    for (auto _ : state) {
+        BensonResult result = bensonAlive(black, white);
+        alive = result.alive.count();
+        benchmark::DoNotOptimize(result);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["AliveStones"] = alive;
+}
+BENCHMARK(BM_BensonAlive);
+
+// Benchmark playouts that stop once Benson settles the winner; Arg 0 is the
+// unchecked baseline the other intervals are measured against
+static void BM_PlayoutSettled(benchmark::State& state) {
+    std::mt19937 gen(42);
+    size_t moves = 0;
+    size_t settled = 0;
+    
+    for (auto _ : state) {
+        PlayoutBoard board;
+        PlayoutResult result = playoutUntilSettled(board, gen, 7.5f, state.range(0));
+        moves += result.moves;
+        settled += result.settled;
+        benchmark::DoNotOptimize(result);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["MovesPerPlayout"] = double(moves) / state.iterations();
+    state.counters["SettledRate"] = double(settled) / state.iterations();
+}
+BENCHMARK(BM_PlayoutSettled)->Arg(0)->Arg(16)->Arg(32)->Arg(64); // Check interval in moves
+
+// Benchmark dead-stone estimation on a position 200 moves into a random game
+static void BM_DeadStoneEstimate(benchmark::State& state) {
+    std::mt19937 gen(11);
+    PlayoutBoard board;
+    board.playout(gen, 200);
+    State position = board.toState();
+    int deadStones = 0;
+    
+    for (auto _ : state) {
+        DeadStones dead = estimateDeadStones(position, gen, state.range(0));
+        deadStones = dead.black.count() + dead.white.count();
+        benchmark::DoNotOptimize(dead);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["DeadStones"] = deadStones;
+}
+BENCHMARK(BM_DeadStoneEstimate)->Arg(8)->Arg(32); // Playouts per estimate
+
+// Self-play with a fixed playout budget per decision. Without reuse the tree
+// is rebuilt every move; with reuse the played child's subtree is kept.
+// EffectivePlayouts is the root visit count when the move is chosen.
+static void BM_SearchDecision(benchmark::State& state) {
+    const bool reuse = state.range(0);
+    const int budget = 2000;
+    const int decisions = 4;
+    size_t effective = 0;
+    size_t made = 0;
+    
+    for (auto _ : state) {
+        UctSearch search(PlayoutBoard(), 64 << 20);
+        for (int d = 0; d < decisions; ++d) {
+            search.run(budget);
+            effective += search.root().visits;
+            int move = search.bestMove();
+            if (reuse) {
+                search.advance(move);
+            } else {
+                PlayoutBoard next = search.rootBoard;
+                next.play(move);
+                search.setPosition(next);
+            }
+        }
+        made += decisions;
+    }
+    
+    state.SetItemsProcessed(made);
+    state.counters["EffectivePlayouts"] = double(effective) / made;
+}
+BENCHMARK(BM_SearchDecision)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond); // Without, with reuse
+
+// Decisions against an opponent that takes 50 ms to answer. With pondering
+// (range 1) the tree keeps growing during that time and the reply's subtree
+// is kept; the opponent's reply itself comes from a small separate search.
+static void BM_SearchPonder(benchmark::State& state) {
+    const bool ponder = state.range(0);
+    const int budget = 1000;
+    const int decisions = 3;
+    size_t effective = 0;
+    size_t made = 0;
+    
+    for (auto _ : state) {
+        UctSearch search(PlayoutBoard(), 64 << 20);
+        for (int d = 0; d < decisions; ++d) {
+            search.run(budget);
+            effective += search.root().visits;
+            search.advance(search.bestMove());
+            
+            if (ponder) search.startPondering();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            search.stopPondering();
+            
+            UctSearch opponent(search.rootBoard, 4 << 20, 1000 + d);
+            opponent.run(200);
+            search.advance(opponent.bestMove());
+        }
+        made += decisions;
+    }
+    
+    state.SetItemsProcessed(made);
+    state.counters["EffectivePlayouts"] = double(effective) / made;
+}
+BENCHMARK(BM_SearchPonder)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond); // Without, with pondering
+
+// Benchmark search iterations with and without AMAF/RAVE bookkeeping
+static void BM_SearchRaveCost(benchmark::State& state) {
+    const int playouts = 1000;
+    
+    for (auto _ : state) {
+        UctSearch search(PlayoutBoard(), 64 << 20);
+        search.rave = state.range(0);
+        search.run(playouts);
+        benchmark::DoNotOptimize(search.root());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * playouts);
+}
+BENCHMARK(BM_SearchRaveCost)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond); // Plain UCT, RAVE
+
+// Full games at 2 ms per move, RAVE against plain UCT with colours alternating,
+// scored with estimated dead stones. Cutting games short is not an option:
+// mid-game estimates from random playouts do not predict the final result.
+// The argument is the number of games; WinRateStdErr says how far apart two
+// win rates must be (about twice that) before the difference means anything.
+static void BM_RaveStrength(benchmark::State& state) {
+    const auto thinkTime = std::chrono::milliseconds(2);
+    const int games = state.range(0);
+    const int maxMoves = 3 * 361;
+    int raveWins = 0;
+    int played = 0;
+    
+    for (auto _ : state) {
+        for (int g = 0; g < games; ++g) {
+            bool raveIsBlack = g % 2 == 0;
+            UctSearch black(PlayoutBoard(), 32 << 20, 100 + g);
+            UctSearch white(PlayoutBoard(), 32 << 20, 200 + g);
+            (raveIsBlack ? black : white).rave = true;
+            
+            for (int m = 0; m < maxMoves && black.rootBoard.passes < 2; ++m) {
+                UctSearch& mover = black.rootBoard.blackToMove ? black : white;
+                mover.runFor(thinkTime);
+                int move = mover.bestMove();
+                black.advance(move);
+                white.advance(move);
+            }
+            
+            std::mt19937 gen(g);
+            State final_state = black.rootBoard.toState();
+            float score = scoreFinished(final_state, estimateDeadStones(final_state, gen));
+            if ((score > 0) == raveIsBlack) raveWins++;
+            played++;
+        }
+    }
+    
+    double winRate = double(raveWins) / played;
+    state.counters["RaveWinRate"] = winRate;
+    state.counters["WinRateStdErr"] = std::sqrt(winRate * (1 - winRate) / played);
+    state.counters["Games"] = played;
+}
+BENCHMARK(BM_RaveStrength)->Arg(100)->Iterations(1)->Unit(benchmark::kMillisecond); // Games
+
+// Per-move cost of each rule set: full uniform playouts, so the superko rule
+// sets pay a hash lookup for every candidate move
+template <class Rules>
+static void BM_PlayoutRules(benchmark::State& state) {
+    std::mt19937 gen(42);
+    size_t moves = 0;
+    double totalScore = 0;
+    
+    for (auto _ : state) {
+        BasicPlayoutBoard<Rules> board;
+        moves += board.playout(gen);
+        totalScore += board.score();
+        benchmark::DoNotOptimize(board);
+    }
+    
+    state.SetItemsProcessed(moves);
+    state.counters["MovesPerPlayout"] = double(moves) / state.iterations();
+    state.counters["NsPerMove"] = benchmark::Counter(double(moves), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["MeanScore"] = totalScore / state.iterations();
+}
+BENCHMARK_TEMPLATE(BM_PlayoutRules, PlayoutRules);
+BENCHMARK_TEMPLATE(BM_PlayoutRules, JapaneseRules);
+BENCHMARK_TEMPLATE(BM_PlayoutRules, ChineseRules);
+BENCHMARK_TEMPLATE(BM_PlayoutRules, TrompTaylorRules);
+BENCHMARK_TEMPLATE(BM_PlayoutRules, NewZealandRules);
+
+// Mid-game positions: 150 pattern-playout moves from the empty board
+static std::vector<State> midGamePositions(int count) {
+    static const PatternTable table = PatternTable::defaults();
+    std::mt19937 gen(42);
+    std::vector<State> positions;
+    for (int i = 0; i < count; ++i) {
+        PlayoutBoard board(&table);
+        board.playout(gen, 150);
+        positions.push_back(board.toState());
+    }
+    return positions;
+}
+
+static void BM_TerritoryEstimate(benchmark::State& state) {
+    std::vector<State> positions = midGamePositions(64);
+    size_t i = 0;
+    
+    for (auto _ : state) {
+        TerritoryEstimate estimate = estimateTerritory(positions[i]);
+        benchmark::DoNotOptimize(estimate);
+        if (++i == positions.size()) i = 0;
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TerritoryEstimate);
+
+static void BM_TerritoryEstimateBatch(benchmark::State& state) {
+    std::vector<State> positions = midGamePositions(state.range(0));
+    std::vector<TerritoryEstimate> estimates(positions.size());
+    
+    for (auto _ : state) {
+        estimateTerritory(positions.data(), positions.size(), estimates.data());
+        benchmark::DoNotOptimize(estimates.data());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TerritoryEstimateBatch)->Arg(64)->Arg(1024); // Positions per batch
+
+// Live games for the validation benchmarks: 1024 distinct mid-game positions
+// repeated to fill 400000 boards. Only the addresses matter to the caches;
+// the first 1024 boards (about 93 KB) stay in L2, all of them (about 36 MB)
+// are far past the last level, as with bursts across thousands of games.
+static const std::vector<State>& liveGames() {
+    static const std::vector<State> boards = [] {
+        std::vector<State> distinct = midGamePositions(1024);
+        std::vector<State> all;
+        for (size_t i = 0; i < 400000; ++i) all.push_back(distinct[i % distinct.size()]);
+        return all;
+    }();
+    return boards;
+}
+
+// Bursts of client moves over live games, each request a random point of a
+// random game
+static void BM_ValidateMoves(benchmark::State& state) {
+    const std::vector<State>& boards = liveGames();
+    std::mt19937 gen(7);
+    std::vector<MoveRequest> requests(state.range(0));
+    for (MoveRequest& r : requests) r = { &boards[gen() % state.range(1)], int16_t(gen() % 361) };
+    std::vector<MoveValidation> results(requests.size());
+    
+    for (auto _ : state) {
+        MoveValidator::validate(requests.data(), requests.size(), results.data());
+        benchmark::DoNotOptimize(results.data());
+    }
+    
+    size_t legal = 0;
+    for (const MoveValidation& r : results) legal += r.verdict == MoveVerdict::Legal;
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["ValidationsPerSecond"] = benchmark::Counter(double(state.iterations()) * state.range(0), benchmark::Counter::kIsRate);
+    state.counters["LegalFraction"] = double(legal) / results.size();
+}
+BENCHMARK(BM_ValidateMoves)->ArgsProduct({{256, 4096, 65536}, {1024, 400000}}); // Requests per batch, games
+
+// One thread, 65536 requests over 400000 games: 0 = in order with prefetch
+// (what validate does), 1 = in order without prefetch, 2 = sorted by board
+// address first (then prefetched too), results scattered back to request order
+static void BM_ValidateMovesOrder(benchmark::State& state) {
+    const std::vector<State>& boards = liveGames();
+    std::mt19937 gen(7);
+    std::vector<MoveRequest> requests(65536);
+    for (MoveRequest& r : requests) r = { &boards[gen() % boards.size()], int16_t(gen() % 361) };
+    std::vector<MoveValidation> results(requests.size());
+    std::vector<MoveRequest> sorted(requests.size());
+    std::vector<MoveValidation> sortedResults(requests.size());
+    std::vector<uint32_t> order(requests.size());
+    
+    for (auto _ : state) {
+        if (state.range(0) < 2) {
+            MoveValidator::validateRange(requests.data(), requests.size(), results.data(),
+                                         state.range(0) == 0 ? MoveValidator::kPrefetchDistance : 0);
+        } else {
+            for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return requests[a].board < requests[b].board; });
+            for (size_t i = 0; i < order.size(); ++i) sorted[i] = requests[order[i]];
+            MoveValidator::validateRange(sorted.data(), sorted.size(), sortedResults.data());
+            for (size_t i = 0; i < order.size(); ++i) results[order[i]] = sortedResults[i];
+        }
+        benchmark::DoNotOptimize(results.data());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * requests.size());
+}
+BENCHMARK(BM_ValidateMovesOrder)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond); // Prefetch, none, sorted
+
+// Random seeks into 300-move games at different checkpoint intervals
+static void BM_HistorySeek(benchmark::State& state) {
+    static const PatternTable table = PatternTable::defaults();
+    std::mt19937 gen(42);
+    std::vector<GameHistory> games;
+    for (int g = 0; g < 16; ++g) {
+        PlayoutBoard board(&table);
+        GameHistory history(board.toState(), state.range(0));
+        while (history.size() < 300) {
+            int move = board.sampleMove(gen);
+            board.play(move);
+            history.push(move);
+        }
+        games.push_back(history);
+    }
+    size_t bytes = 0;
+    for (const GameHistory& h : games) bytes += h.memoryBytes();
+    
+    for (auto _ : state) {
+        const GameHistory& h = games[gen() % games.size()];
+        State s = h.at(gen() % (h.size() + 1));
+        benchmark::DoNotOptimize(s);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["BytesPerGame"] = double(bytes) / games.size();
+}
+BENCHMARK(BM_HistorySeek)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(512); // Checkpoint interval
+
+// Playouts on every worker of every node. Arg 0 keeps boards and pattern
+// tables on the worker's node; Arg 1 has every task copy its board from one
+// built by the main thread and read node 0's table, as a naive pool would.
+// On a single-node machine the two match.
+static void BM_WorkerPoolPlayouts(benchmark::State& state) {
+    static const PatternTable table = PatternTable::defaults();
+    WorkerPool pool(NumaTopology::detect(), &table);
+    bool remote = state.range(0) == 1;
+    PlayoutBoard shared(pool.tableOnNode(0));
+    std::vector<std::atomic<uint64_t>> nodePlayouts(pool.numNodes());
+    
+    for (auto _ : state) {
+        for (int node = 0; node < pool.numNodes(); ++node) {
+            for (size_t i = 0; i < 16 * pool.workersOnNode(node).size(); ++i) {
+                pool.submit(node, [&, node](WorkerContext& ctx) {
+                    if (remote) ctx.board = shared;
+                    else ctx.board.clear();
+                    ctx.board.playout(ctx.rng);
+                    nodePlayouts[node].fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        }
+        pool.wait();
+    }
+    
+    state.counters["UnpinnedWorkers"] = pool.unpinnedWorkers();
+    uint64_t total = 0;
+    for (int node = 0; node < pool.numNodes(); ++node) {
+        total += nodePlayouts[node];
+        state.counters["Node" + std::to_string(node) + "PlayoutsPerSecond"] =
+            benchmark::Counter(double(nodePlayouts[node]), benchmark::Counter::kIsRate);
+    }
+    uint64_t stolen = 0;
+    for (int w = 0; w < pool.numWorkers(); ++w) stolen += pool.context(w).tasksStolen;
+    state.SetItemsProcessed(total);
+    state.counters["Workers"] = pool.numWorkers();
+    state.counters["StolenFraction"] = double(stolen) / std::max<uint64_t>(1, total);
+}
+BENCHMARK(BM_WorkerPoolPlayouts)->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond); // Node-local, shared
+
+// Self-play games from the empty board over N worker processes, 64 games per
+// iteration in batches of 8. Coordinator time is the time not spent blocked
+// in poll().
+static void BM_SelfPlayProcesses(benchmark::State& state) {
+    static const PatternTable table = PatternTable::defaults();
+    SelfPlayCoordinator coordinator(state.range(0), &table);
+    std::vector<SelfPlayJob> jobs(64);
+    uint32_t seed = 1;
+    size_t games = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < jobs.size(); ++i) jobs[i] = { i, seed++, State() };
+        std::vector<SelfPlayResult> results;
+        if (!coordinator.run(jobs, results)) {
+            state.SkipWithError("self-play workers could not be started");
+            return;
+        }
+        games += results.size();
+        benchmark::DoNotOptimize(results.data());
+    }
+    
+    double wall = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double busy = coordinator.busyTime().count();
+    state.SetItemsProcessed(games);
+    state.counters["GamesPerSecond"] = benchmark::Counter(double(games), benchmark::Counter::kIsRate);
+    state.counters["CoordinatorNsPerGame"] = busy / games;
+    state.counters["CoordinatorFraction"] = busy / wall;
+}
+BENCHMARK(BM_SelfPlayProcesses)->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond); // Worker processes
+
+// Corpus of 256 complete pattern-playout games in readGameRecord's text form
+static const std::string& benchCorpus() {
+    static std::string corpus;
+    if (corpus.empty()) {
+        static const PatternTable table = PatternTable::defaults();
+        std::mt19937 gen(42);
+        std::ostringstream out;
+        for (int g = 0; g < 256; ++g) {
+            PlayoutBoard board(&table);
+            std::vector<int> moves;
+            while (board.passes < 2 && moves.size() < 3 * 361) {
+                moves.push_back(board.sampleMove(gen));
+                board.play(moves.back());
+            }
+            out << (board.score() > 0 ? "B" : "W");
+            for (int m : moves) out << ' ' << m;
+            out << '\n';
+        }
+        corpus = out.str();
+    }
+    return corpus;
+}
+
+// Full statistics over the corpus with N workers; Arg is the total worker count
+static void BM_CorpusAnalytics(benchmark::State& state) {
+    NumaTopology topology = NumaTopology::detect();
+    WorkerPool pool(topology, nullptr, std::max<int>(1, state.range(0) / topology.numNodes()));
+    const std::string& corpus = benchCorpus();
+    CorpusStats stats;
+    
+    for (auto _ : state) {
+        std::istringstream in(corpus);
+        stats = analyzeCorpus(in, pool, CorpusStats(), 16);
+        benchmark::DoNotOptimize(stats);
+    }
+    
+    state.SetItemsProcessed(state.iterations() * stats.games);
+    state.counters["PositionsPerSecond"] = benchmark::Counter(double(state.iterations() * stats.positions), benchmark::Counter::kIsRate);
+    state.counters["CapturedPerGame"] = double(stats.capturedStones) / stats.games;
+    state.counters["KoFightGames"] = stats.koFightGames;
+}
+BENCHMARK(BM_CorpusAnalytics)->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond); // Workers
+
+// Bounded integers: std::mt19937 with uniform_int_distribution against
+// xoshiro256++ with bitmask rejection
+static void BM_RandomBelow(benchmark::State& state) {
+    std::mt19937 mt(42);
+    Xoshiro256pp xo(42);
+    uint64_t sum = 0;
+    
+    for (auto _ : state) {
+        if (state.range(0) == 0) sum += std::uniform_int_distribution<uint32_t>(0, 360)(mt);
+        else sum += xo.below(361);
+    }
+    
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomBelow)->Arg(0)->Arg(1); // mt19937, xoshiro256++
+
+// Picking a random empty point with N stones on the board. Method 0 is what
+// BM_GameSimulation does: mt19937 draws until isEmpty() holds. Method 1 draws
+// once from an empty mask the caller keeps; method 2 also extracts the mask
+// from the State first.
+static void BM_RandomMoveSelection(benchmark::State& state) {
+    int method = state.range(0);
+    int stones = state.range(1);
+    State go_state;
+    std::mt19937 fill(3);
+    for (int placed = 0; placed < stones;) {
+        int bitIndex = (placed % 2 ? 361 : 0) + fill() % 361;
+        int idx = bitIndex % 361;
+        if (go_state.getBlack(idx) || go_state.getWhite(idx)) continue;
+        go_state.data[bitIndex / 8] |= (1 << (bitIndex % 8));
+        placed++;
+    }
+    std::mt19937 mt(42);
+    std::uniform_int_distribution<> dist(0, 360);
+    Xoshiro256pp xo(42);
+    Bitboard empty = Bitboard::board.andNot(Bitboard::fromState(go_state, true) | Bitboard::fromState(go_state, false));
+    
+    for (auto _ : state) {
+        int pos;
+        if (method == 0) {
+            do pos = dist(mt); while (!go_state.isEmpty(pos));
+        } else if (method == 1) {
+            pos = pickUniform(empty, xo);
+        } else {
+            Bitboard current = Bitboard::board.andNot(Bitboard::fromState(go_state, true) | Bitboard::fromState(go_state, false));
+            pos = pickUniform(current, xo);
+        }
+        benchmark::DoNotOptimize(pos);
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomMoveSelection)->ArgsProduct({{0, 1, 2}, {20, 180, 340}}); // Method, stones on board
+
+// Counter-seeded playouts over N workers; Checksum is identical for every N
+static void BM_ReproduciblePlayouts(benchmark::State& state) {
+    NumaTopology topology = NumaTopology::detect();
+    WorkerPool pool(topology, nullptr, std::max<int>(1, state.range(0) / topology.numNodes()));
+    PlayoutBoard start;
+    double checksum = 0;
+    
+    for (auto _ : state) {
+        std::vector<float> scores = runPlayouts(pool, start, 256, 2024);
+        checksum = 0;
+        for (size_t i = 0; i < scores.size(); ++i) checksum += scores[i] * (i + 1);
+    }
+    
+    state.SetItemsProcessed(state.iterations() * 256);
+    state.counters["Checksum"] = checksum;
+}
+BENCHMARK(BM_ReproduciblePlayouts)->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond); // Workers
+
+// Opening book built from random games. The positions of the first games are
+// kept to look up: Arg 0 looks up book positions, Arg 1 positions past the
+// book's depth, which miss.
+static const char* kBenchBookPath = "/tmp/gobenchmark_opening.book";
+
+static const std::vector<State>& openingBookPositions(bool inBook) {
+    static std::vector<State> hits, misses;
+    if (hits.empty()) {
+        static const PatternTable table = PatternTable::defaults();
+        std::mt19937 gen(42);
+        OpeningBookBuilder builder(30);
+        for (int g = 0; g < 20000; ++g) {
+            PlayoutBoard board(&table);
+            GameRecord record;
+            for (int i = 0; i < 40; ++i) {
+                if (g < 256) (i < 30 ? hits : misses).push_back(board.toState());
+                int move = board.sampleMove(gen);
+                record.moves.push_back(int16_t(move));
+                board.play(move);
+            }
+            board.playout(gen);
+            record.winner = board.score() > 0 ? 1 : -1;
+            builder.addGame(record);
+        }
+        builder.write(kBenchBookPath);
+    }
+    return inBook ? hits : misses;
+}
+
+static void BM_OpeningBookLookup(benchmark::State& state) {
+    const std::vector<State>& positions = openingBookPositions(state.range(0) == 0);
+    OpeningBook book;
+    if (!book.open(kBenchBookPath)) {
+        state.SkipWithError("could not open book");
+        return;
+    }
+    size_t i = 0, found = 0;
+    
+    for (auto _ : state) {
+        int move = book.bestMove(positions[i]);
+        found += move != OpeningBook::kOutOfBook;
+        benchmark::DoNotOptimize(move);
+        if (++i == positions.size()) i = 0;
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+    state.counters["HitRate"] = double(found) / state.iterations();
+    state.counters["BookEntries"] = book.size();
+}
+BENCHMARK(BM_OpeningBookLookup)->Arg(0)->Arg(1); // In book, out of book
+
+// Opening maps the file and checks the header; nothing is parsed
+static void BM_OpeningBookOpen(benchmark::State& state) {
+    openingBookPositions(true);
+    
+    for (auto _ : state) {
+        OpeningBook book;
+        bool ok = book.open(kBenchBookPath);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(BM_OpeningBookOpen)->Unit(benchmark::kMicrosecond);
+
+// Main function for benchmarks
+BENCHMARK_MAIN();
+
+#else
+
+// MARK: --- Game Main Function ---
+int main() {
+    State s;
+    s.setGameActive(1);
+    int passes = 0;
     
     while (s.getGameActive()) {
         std::cout << "\n";
+        int idx = s.getTurnState() ? s.wIn() : s.bIn();
+        
+        // Off-board coordinates pass; two passes in a row end the game
+        if (idx < 0 || idx >= 361) {
+            s.setTurnState(!s.getTurnState());
+            if (++passes == 2) s.setGameActive(false);
+            continue;
+        }
+        passes = 0;
+        
         if (s.getTurnState()) {
-            s.setWhite(s.wIn(), true);
+            s.setWhite(idx, true);
         } else {
-            s.setBlack(s.bIn(), true);
+            s.setBlack(idx, true);
         }
     } 
+    
+    std::mt19937 gen(std::random_device{}());
+    float result = scoreFinished(s, estimateDeadStones(s, gen));
+    std::cout << (result > 0 ? "B+" : "W+") << (result > 0 ? result : -result) << "\n";
     return 0;
 }
 